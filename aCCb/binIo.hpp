@@ -14,7 +14,7 @@ namespace binIo = aCCb::binaryIo;
 //* vec2stream: Write vector as binary into stream */
 template <class T>
 void vec2stream(std::ostream &os, const vector<T> &vec) {
-    os.write((char *)&vec[0], vec.size() * sizeof(T));
+    os.write((const char *)vec.data(), vec.size() * sizeof(T));
 }
 //* vec2file: Write vector as binary into file */
 template <class T>
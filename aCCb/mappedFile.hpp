@@ -0,0 +1,101 @@
+#pragma once
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX  // windows.h would otherwise break std::min, std::max
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace aCCb {
+// read-only memory mapping of a complete file
+class mappedFile {
+   public:
+    mappedFile(const std::string &filename) {
+#ifdef _WIN32
+        hFile = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (hFile == INVALID_HANDLE_VALUE)
+            throw std::runtime_error("failed to open file: " + filename);
+        LARGE_INTEGER s;
+        if (!GetFileSizeEx(hFile, &s)) {
+            CloseHandle(hFile);
+            throw std::runtime_error("failed to get file size: " + filename);
+        }
+        nBytes = (size_t)s.QuadPart;
+        if (nBytes > 0) {
+            hMapping = CreateFileMappingA(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+            if (hMapping)
+                pData = (const char *)MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+            if (!pData) {
+                if (hMapping)
+                    CloseHandle(hMapping);
+                CloseHandle(hFile);
+                throw std::runtime_error("failed to map file: " + filename);
+            }
+        }
+#else
+        fd = open(filename.c_str(), O_RDONLY);
+        if (fd < 0)
+            throw std::runtime_error("failed to open file: " + filename);
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            close(fd);
+            throw std::runtime_error("failed to get file size: " + filename);
+        }
+        nBytes = (size_t)st.st_size;
+        if (nBytes > 0) {
+            void *p = mmap(NULL, nBytes, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p == MAP_FAILED) {
+                close(fd);
+                throw std::runtime_error("failed to map file: " + filename);
+            }
+            pData = (const char *)p;
+        }
+#endif
+    }
+
+    mappedFile(const mappedFile &) = delete;
+    mappedFile &operator=(const mappedFile &) = delete;
+
+    ~mappedFile() {
+#ifdef _WIN32
+        if (pData)
+            UnmapViewOfFile(pData);
+        if (hMapping)
+            CloseHandle(hMapping);
+        CloseHandle(hFile);
+#else
+        if (pData)
+            munmap((void *)pData, nBytes);
+        close(fd);
+#endif
+    }
+
+    // file contents (NULL if empty)
+    const char *data() const {
+        return pData;
+    }
+
+    size_t size() const {
+        return nBytes;
+    }
+
+   protected:
+    const char *pData = NULL;
+    size_t nBytes = 0;
+#ifdef _WIN32
+    HANDLE hFile = INVALID_HANDLE_VALUE;
+    HANDLE hMapping = NULL;
+#else
+    int fd = -1;
+#endif
+};
+}  // namespace aCCb
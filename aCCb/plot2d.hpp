@@ -7,7 +7,9 @@
 #include <cassert>
 #include <chrono>
 #include <cmath>  // isinf
+#include <cstdlib>  // strtod
 #include <future>
+#include <iomanip>  // setprecision
 #include <iostream>
 #include <limits>  // inf
 #include <sstream>
@@ -213,6 +215,17 @@ class plot2d : public Fl_Box {
                 case 'm':
                     parent->toggleCursor();
                     return true;
+                case 'v':
+                    parent->allDrawJobs.setAllVisible();
+                    parent->invalidate(/*full redraw*/ true);
+                    return true;
+            }
+            // === '1'..'9', '0': toggle visibility of traces 1..10 ===
+            if ((key >= '0') && (key <= '9')) {
+                size_t ixTrace = (key == '0') ? 9 : key - '1';
+                if (parent->allDrawJobs.toggleVisible(ixTrace))
+                    parent->invalidate(/*full redraw*/ true);
+                return true;
             }
             return false;
         }
@@ -251,17 +264,19 @@ class plot2d : public Fl_Box {
         double y1tmp = std::max(y0, y1);
 
         // === enforce minimum span ===
-        // (approx. limit of float precision in 1920x1080 resolution)
-        const double minSpan = 5e-12;
-        if ((x1tmp - x0tmp) < minSpan) {
+        // (some steps of double precision at the magnitude of the view e.g. 2 us for ns timestamps. Data is projected relative to the view, see proj)
+        auto minSpan = [](double v0, double v1) { return std::max(5e-12, 1e-15 * std::max(std::abs(v0), std::abs(v1))); };
+        const double minSpanX = minSpan(x0tmp, x1tmp);
+        if ((x1tmp - x0tmp) < minSpanX) {
             double avg = (x0tmp + x1tmp) / 2.0;
-            x0tmp = avg - minSpan / 2.0;
-            x1tmp = avg + minSpan / 2.0;
+            x0tmp = avg - minSpanX / 2.0;
+            x1tmp = avg + minSpanX / 2.0;
         }
-        if ((y1tmp - y0tmp) < minSpan) {
+        const double minSpanY = minSpan(y0tmp, y1tmp);
+        if ((y1tmp - y0tmp) < minSpanY) {
             double avg = (y0tmp + y1tmp) / 2.0;
-            y0tmp = avg - minSpan / 2.0;
-            y1tmp = avg + minSpan / 2.0;
+            y0tmp = avg - minSpanY / 2.0;
+            y1tmp = avg + minSpanY / 2.0;
         }
 
         this->x0 = x0tmp;
@@ -341,20 +356,20 @@ class plot2d : public Fl_Box {
         if (false == (scaleX0 | scaleX1))
             return true;  // nothing to do
 
-        const double inf = std::numeric_limits<float>::infinity();
+        const double inf = std::numeric_limits<double>::infinity();
         // autoscale: extend inversed range to fit each item
-        float x0f = inf;
-        float x1f = -inf;
+        double x0f = inf;
+        double x1f = -inf;
 
         allDrawJobs.updateAutoscaleX(x0f, x1f);
 
         // convert infinity to "large" number
-        const float INFTY = 1e16;  // fallback: "10 tera"
+        const double INFTY = 1e16;  // fallback: "10 tera"
         if (std::isinf(x0f)) x0f = -INFTY;
         if (std::isinf(x1f)) x1f = INFTY;
 
         // apply result, if meaningful
-        const float eps = 1e-16;  // fallback: "0.1 femto"
+        const double eps = 1e-16;  // fallback: "0.1 femto"
         // check for non-zero span
         bool validX = (scaleX1 ? x1f : x1) - (scaleX0 ? x0f : x0) > eps;
         if (scaleX0 && validX) x0 = x0f;
@@ -376,20 +391,20 @@ class plot2d : public Fl_Box {
         if (false == (scaleY0 | scaleY1))
             return true;  // nothing to do
 
-        const double inf = std::numeric_limits<float>::infinity();
+        const double inf = std::numeric_limits<double>::infinity();
         // autoscale: extend inversed range to fit each item
-        float y0f = inf;
-        float y1f = -inf;
+        double y0f = inf;
+        double y1f = -inf;
 
         allDrawJobs.updateAutoscaleY(y0f, y1f);
 
         // convert infinity to "large" number
-        const float INFTY = 1e16;  // fallback: "10 tera"
+        const double INFTY = 1e16;  // fallback: "10 tera"
         if (std::isinf(y0f)) y0f = -INFTY;
         if (std::isinf(y1f)) y1f = INFTY;
 
         // apply result, if meaningful
-        const float eps = 1e-16;  // fallback: "0.1 femto"
+        const double eps = 1e-16;  // fallback: "0.1 femto"
         bool validY = (scaleY1 ? y1f : y1) - (scaleY0 ? y0f : y0) > eps;
         if (scaleY0 && validY) y0 = y0f;
         if (scaleY1 && validY) y1 = y1f;
@@ -405,6 +420,29 @@ class plot2d : public Fl_Box {
         return true;
     }
 
+    // sets the visible area from outside e.g. to follow new data. Triggers redraw
+    void setView(double x0, double y0, double x1, double y1) {
+        setViewArea(x0, y0, x1, y1, /*resetAxes*/ true);
+    }
+
+    // changes trace data via fn (e.g. allDrawJobs_cl::replaceDrawJob) while point lookup in the background is held off.
+    // If fn returns true (data has changed), redraws and looks up the point under the cursor again
+    template <typename fn_t>
+    void updateData(fn_t fn) {
+        {
+            std::unique_lock<std::mutex> lock = annotator.lockData();
+            if (!fn())
+                return;
+        }
+        cursorHighlight.highlightValid = false;
+        cursorHighlight.updateAnnotations(allDrawJobs);
+        if (!std::isnan(cursorHighlight.cursorX) && !std::isnan(cursorHighlight.cursorY)) {
+            proj<double> p = projDataToScreen<double>();
+            annotator.notifyCursorChange(cursorHighlight.cursorX, cursorHighlight.cursorY, p);
+        }
+        invalidate(/*full redraw*/ true);
+    }
+
     void invalidate(bool needFullRedraw) {
         this->needFullRedraw = needFullRedraw;
         redraw();
@@ -699,7 +737,7 @@ class plot2d : public Fl_Box {
         // === draw highlighted point ===
         if (cursorFlag && cursorHighlight.highlightValid) {
             fl_push_clip(screenX, screenY, width, height);
-            float x, y;
+            double x, y;
             allDrawJobs.getPt(cursorHighlight.highlightIxTrace, cursorHighlight.highlightIxPt, x, y);
             int xs = pd.projX(x);
             int ys = pd.projY(y);
@@ -734,7 +772,7 @@ class plot2d : public Fl_Box {
 
     // event manager calls this for cursor, annotation search update
     void notifyCursorMove(double dataX, double dataY) {
-        proj<float> p = projDataToScreen<float>();
+        proj<double> p = projDataToScreen<double>();
         annotator.notifyCursorChange(dataX, dataY, p);
         cursorHighlight.notifyCursorChange(dataX, dataY, allDrawJobs);
         // first redraw: Cursor changed, annotation (probably) still pending
@@ -797,11 +835,10 @@ class plot2d : public Fl_Box {
             annot.push_back(ss.str());
 
             if (highlightValid) {
-                float x, y;
+                double x, y, resX, resY;
                 adj.getPt(highlightIxTrace, highlightIxPt, x, y);
-                ss = std::stringstream();
-                ss << " pt:[" << x << ", " << y << "] ";
-                annot.push_back(ss.str());
+                adj.getPtResolution(highlightIxTrace, highlightIxPt, resX, resY);
+                annot.push_back(" pt:[" + formatValue(x, resX) + ", " + formatValue(y, resY) + "] ");
 
                 vector<string> allAnnot = adj.getAnnotations(highlightIxTrace, highlightIxPt);
                 for (const string& oneAnnot : allAnnot)
@@ -809,6 +846,17 @@ class plot2d : public Fl_Box {
             }
         }
 
+        // v with the digits its data resolves (res: see column_cl::getResolution), at least 6. E.g. full precision for timestamps, none of the float noise of rebased data
+        static string formatValue(double v, double res) {
+            std::stringstream ss;
+            for (int digits = 6;; ++digits) {
+                ss = std::stringstream();
+                ss << std::setprecision(digits) << v;
+                if (!std::isfinite(v) || (digits >= std::numeric_limits<double>::max_digits10) || (std::fabs(std::strtod(ss.str().c_str(), NULL) - v) <= res / 2))
+                    return ss.str();
+            }
+        }
+
         void notifyCursorChange(double cursorX, double cursorY, allDrawJobs_cl& adj) {
             this->cursorX = cursorX;
             this->cursorY = cursorY;
@@ -1,5 +1,15 @@
 #pragma once
+#include <algorithm>  // min, max, sort
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <deque>
+#include <future>
+#include <limits>
+#include <stdexcept>
 #include <string>
+#include <thread>  // hardware_concurrency
+#include <utility>  // pair
 #include <vector>
 
 #include "drawJob.hpp"
@@ -15,71 +25,231 @@ class allDrawJobs_cl {
         int screenHeight = p.getScreenHeight();
         int screenX = p.getScreenX0();
         int screenY = p.getScreenY1();
+        if ((screenWidth <= 0) || (screenHeight <= 0))
+            return;
 
-        /* Projection to stencil at x=0 Y=0 */
-        const proj<float> projStencil(p.getDataX0(), p.getDataY1(), p.getDataX1(), p.getDataY0(), /*stencil X0*/ 0, /*stencil Y0*/ 0, /*stencil X1*/ screenWidth, /*stencil Y1*/ screenHeight);
+        /* Projection to stencil at x=0 Y=0 (double: the kernels convert, see drawJob::drawChunk) */
+        const proj<double> projStencil(p.getDataX0(), p.getDataY1(), p.getDataX1(), p.getDataY0(), /*stencil X0*/ 0, /*stencil Y0*/ 0, /*stencil X1*/ screenWidth, /*stencil Y1*/ screenHeight);
 
-        // ... combine subsequent traces with same marker into a  common stencil
-        vector<stencil_t> stencil(screenWidth * screenHeight);
+        // === pre-scaled point coordinates for panning ===
+        updatePanCaches(projStencil);
 
-        // ... then render the stencil using the marker into rgba
-        vector<uint32_t> rgba(screenWidth * screenHeight);
+        // === sort visible traces by marker shape ===
+        // Layer ID of a trace is its position + 1 (0: no trace). A higher ID is drawn on top.
+        // Occlusion between traces of a common marker shape is resolved by the ID buffer before convolution, across shapes after convolution.
+        vector<const marker_cl*> shapes;
+        vector<vector<size_t>> ixJobsByShape;
+        vector<uint32_t> rgbaById{/*ID 0: transparent*/ 0};
+        for (size_t ixJob = 0; ixJob < drawJobs.size(); ++ixJob) {
+            rgbaById.push_back(drawJobs[ixJob].marker->rgba);
+            if (!visible[ixJob])
+                continue;
+            const marker_cl* m = drawJobs[ixJob].getShapeMarker();
+            size_t ixShape = 0;
+            while ((ixShape < shapes.size()) && !shapes[ixShape]->sameShape(*m))
+                ++ixShape;
+            if (ixShape == shapes.size()) {
+                shapes.push_back(m);
+                ixJobsByShape.push_back(vector<size_t>());
+            }
+            ixJobsByShape[ixShape].push_back(ixJob);
+        }
+
+        // === same view and traces as the last frame, data only appended: render the new points only ===
+        const bool incremental = keepIdBufs && idBufCache.isAppendOf(projStencil, ixJobsByShape);
+        // (a full redraw without appended data since the last frame: appending has stopped, or the view changes. Don't keep)
+        if (!incremental && !appendedSinceFrame)
+            clearIdBufCache();
+        appendedSinceFrame = false;
+        vector<size_t> ixFirstChunkByJob(drawJobs.size(), 0);
+        if (incremental)
+            for (size_t ixJob = 0; ixJob < drawJobs.size(); ++ixJob)
+                ixFirstChunkByJob[ixJob] = idBufCache.nPointsByJob[ixJob] / drawJob::chunkSize;
+        if (keepIdBufs && !incremental)
+            idBufCache.set(projStencil, ixJobsByShape);
+        if (keepIdBufs) {
+            idBufCache.nPointsByJob.resize(drawJobs.size());
+            for (size_t ixJob = 0; ixJob < drawJobs.size(); ++ixJob)
+                idBufCache.nPointsByJob[ixJob] = drawJobs[ixJob].getNPoints();
+        }
+
+        // === per-trace layers for the current view ===
+        // (once visibility has been toggled. Any view change invalidates. Not for an incremental frame, its traces differ)
+        if (!layerCache.isValidFor(projStencil))
+            layerCache.clear();
+        if (layerCacheEnabled && !incremental && !layerCache.isValidFor(projStencil))
+            buildLayerCache(projStencil);
 
-        const marker_cl* currentMarker = NULL;
-        for (auto it = drawJobs.begin(); it != drawJobs.end(); ++it) {
-            drawJob& j = *it;
-            if (!j.hasPoints()) {
-                // draw lines directly to screen - use of a stencil is inefficient (unless we need it anyway for data)
-                // matters when lines of different colors are used in many plots that show up at the same time
-                j.drawLinesDirectly(p);
+        // === traces with per-pixel color (e.g. density) are rendered into an RGBA layer each ===
+        // (any non-transparent pixel counts as hit)
+        vector<const vector<uint32_t>*> rgbaLayerById(drawJobs.size() + 1, NULL);
+        vector<vector<uint32_t>> rgbaLayers(drawJobs.size());
+        for (size_t ixJob = 0; ixJob < drawJobs.size(); ++ixJob) {
+            if (!visible[ixJob] || !drawJobs[ixJob].hasPerPixelColor())
+                continue;
+            if (layerCache.hasLayersFor(projStencil)) {
+                rgbaLayerById[ixJob + 1] = &layerCache.getRgbaLayer(ixJob);
             } else {
-                bool stencilHoldsIncompatibleData = (currentMarker != NULL) && (currentMarker != j.marker);
-                if (stencilHoldsIncompatibleData) {
-                    // Draw stencil...
-                    vector<stencil_t> sConv = drawJob::convolveStencil(stencil, screenWidth, screenHeight, currentMarker);
-                    drawJob::drawStencil2rgba(sConv, screenWidth, screenHeight, currentMarker, /*out*/ rgba);
-                    drawJob::drawRgba2screen(rgba, screenX, screenY, screenWidth, screenHeight);
-                    // ... and clear
-                    std::fill(stencil.begin(), stencil.end(), 0);
-                }  // if incompatible with stencil contents
-
-                j.drawToStencil(projStencil, /*out*/ stencil);
-                currentMarker = j.marker;
+                rgbaLayers[ixJob] = renderRgbaLayer(drawJobs[ixJob], projStencil);
+                rgbaLayerById[ixJob + 1] = &rgbaLayers[ixJob];
             }
         }
-        // render final stencil
-        if (currentMarker != NULL) {
-            vector<stencil_t> sConv = drawJob::convolveStencil(stencil, screenWidth, screenHeight, currentMarker);
-            drawJob::drawStencil2rgba(sConv, screenWidth, screenHeight, currentMarker, /*out*/ rgba);
-            drawJob::drawRgba2screen(rgba, screenX, screenY, screenWidth, screenHeight);
+
+        // topmost layer ID after convolution
+        vector<layerId_t> idBufConv(screenWidth * screenHeight);
+        vector<vector<layerId_t>> idBufs;
+        for (size_t ixShape = 0; ixShape < shapes.size(); ++ixShape) {
+            // === single pass over the data of all traces with this shape ===
+            const vector<size_t>& ixJobs = ixJobsByShape[ixShape];
+            const bool fromCache = !incremental && layerCache.hasLayersFor(projStencil);
+            if (fromCache)
+                layerCache.composite(ixJobs, /*out*/ idBufs);
+            else
+                renderIdBuf(ixJobs, projStencil, /*out*/ idBufs, ixFirstChunkByJob);
+            // (the ID buffer of the last frame, by max like a thread's)
+            vector<layerId_t>* pKept = keepIdBufs ? &idBufCache.idBufByShape[ixShape] : NULL;
+            if (incremental)
+                idBufs.push_back(std::move(*pKept));
+            if (pKept)
+                pKept->resize(idBufs[0].size());
+
+            // === combine per-thread results (keep them), add RGBA layers, convolve ===
+            parallelRows(screenHeight, [this, &idBufs, &ixJobs, &rgbaLayerById, pKept, fromCache, screenWidth](int rowBegin, int rowEnd) {
+                const size_t ixBegin = (size_t)rowBegin * screenWidth;
+                const size_t ixEnd = (size_t)rowEnd * screenWidth;
+                for (size_t ixBuf = 1; ixBuf < idBufs.size(); ++ixBuf)
+                    for (size_t ix = ixBegin; ix < ixEnd; ++ix)
+                        idBufs[0][ix] = std::max(idBufs[0][ix], idBufs[ixBuf][ix]);
+                if (pKept)
+                    std::copy(idBufs[0].begin() + ixBegin, idBufs[0].begin() + ixEnd, pKept->begin() + ixBegin);
+                if (!fromCache)
+                    for (size_t ixJob : ixJobs) {
+                        if (!drawJobs[ixJob].hasPerPixelColor())
+                            continue;
+                        const layerId_t id = (layerId_t)(ixJob + 1);
+                        const vector<uint32_t>& layer = *rgbaLayerById[id];
+                        for (size_t ix = ixBegin; ix < ixEnd; ++ix)
+                            if (layer[ix])
+                                idBufs[0][ix] = std::max(idBufs[0][ix], id);
+                    }
+            });
+            const marker_cl* shape = shapes[ixShape];
+            parallelRows(screenHeight, [&idBufs, &idBufConv, shape, screenWidth, screenHeight](int rowBegin, int rowEnd) {
+                drawJob::dilateIdBuf(idBufs[0], screenWidth, screenHeight, shape, /*out*/ idBufConv, rowBegin, rowEnd);
+            });
         }
+
+        if (shapes.size() == 0)
+            return;
+
+        // === colorize once and draw ===
+        vector<uint32_t> rgba(screenWidth * screenHeight);
+        parallelRows(screenHeight, [&idBufConv, &rgbaById, &rgbaLayerById, &rgba, screenWidth](int rowBegin, int rowEnd) {
+            drawJob::drawIdBuf2rgba(idBufConv, screenWidth, rgbaById, rgbaLayerById, /*out*/ rgba, rowBegin, rowEnd);
+        });
+        drawJob::drawRgba2screen(rgba, screenX, screenY, screenWidth, screenHeight);
     }
 
     // adds a new drawJob
-    void addDrawJob(drawJob j) {
+    void addDrawJob(drawJob j, bool isVisible = true) {
+        if (drawJobs.size() >= (size_t)std::numeric_limits<layerId_t>::max())
+            throw std::runtime_error("too many traces");
         this->drawJobs.push_back(j);
+        this->visible.emplace_back(isVisible);
+        this->panCaches.emplace_back();
+        assignPanCacheBudgets();
+        if (!isVisible)
+            layerCacheEnabled = true;
+        layerCache.clear();  // (added at run time: the layers are per trace)
+        clearIdBufCache();
+    }
+
+    // replaces the drawJob of a trace e.g. when its data has changed. Derived data (pan cache, layers) is discarded.
+    // appended: j has the points of the old drawJob first (see drawJob append constructor). Then, the pan cache is extended, and the next frame in the same view renders only the new points.
+    // The caller must hold off concurrent point lookup (see annotator_t::lockData)
+    void replaceDrawJob(size_t ixJob, const drawJob& j, bool appended = false) {
+        assert(ixJob < drawJobs.size());
+        panCache_cl& c = panCaches[ixJob];
+        c.cancel = true;
+        if (c.pending.valid())
+            c.pending.wait();  // the build reads the old drawJob
+        c.pending = std::future<drawJob::pixCoords_cl>();
+        c.cancel = false;
+        drawJobs[ixJob] = j;
+        assignPanCacheBudgets();
+        if (!appended || !c.inBudget || !c.coords.valid || !drawJobs[ixJob].extendPixCoords(c.coords, c.cancel))
+            c.coords = drawJob::pixCoords_cl();
+        layerCache.clear();
+        if (appended)
+            keepIdBufs = appendedSinceFrame = true;
+        else
+            clearIdBufCache();
+    }
+
+    size_t getNTraces() const {
+        return drawJobs.size();
+    }
+
+    // enables pan caches (off by default: they take memory, see assignPanCacheBudgets)
+    void setPanCache(bool enable) {
+        panCacheEnabled = enable;
+        assignPanCacheBudgets();
+    }
+
+    const drawJob& getDrawJob(size_t ixTrace) const {
+        assert(ixTrace < drawJobs.size());
+        return drawJobs[ixTrace];
+    }
+
+    // shows or hides a trace. Returns false if there is no such trace.
+    // From here on, per-trace layers are kept so that further changes need no access to the data
+    bool toggleVisible(size_t ixTrace) {
+        if (ixTrace >= drawJobs.size())
+            return false;
+        visible[ixTrace] = !visible[ixTrace];
+        layerCacheEnabled = true;
+        clearIdBufCache();
+        return true;
+    }
+
+    // shows or hides a trace
+    void setVisible(size_t ixTrace, bool isVisible) {
+        assert(ixTrace < drawJobs.size());
+        if (visible[ixTrace] == isVisible)
+            return;
+        visible[ixTrace] = isVisible;
+        layerCacheEnabled = true;
+        clearIdBufCache();
+    }
+
+    // shows all traces
+    void setAllVisible() {
+        for (std::atomic<bool>& v : visible)
+            v = true;
+        layerCacheEnabled = true;
+        clearIdBufCache();
     }
 
     // extends x0, x1 to include x range
-    void updateAutoscaleX(float& x0, float& x1) const {
-        for (auto j : drawJobs)
+    void updateAutoscaleX(double& x0, double& x1) const {
+        for (const drawJob& j : drawJobs)
             j.updateAutoscaleX(x0, x1);
     }
 
     // extends y0, y1 to include y range
-    void updateAutoscaleY(float& y0, float& y1) const {
-        for (auto j : drawJobs)
+    void updateAutoscaleY(double& y0, double& y1) const {
+        for (const drawJob& j : drawJobs)
             j.updateAutoscaleY(y0, y1);
     }
 
     // attempts to locate the on-screen data point closest to xData/yData. Returns true if successful, with trace in ixTrace, point in ixPt.
-    bool findClosestPoint(float xData, float yData, const proj<float>& p, size_t& ixTrace, size_t& ixPt) const {
+    bool findClosestPoint(double xData, double yData, const proj<double>& p, size_t& ixTrace, size_t& ixPt) const {
         bool r = false;
         int bestDist = std::numeric_limits<int>::max();
-        float xScreen = p.projX(xData);
-        float yScreen = p.projY(yData);
+        int xScreen = p.projX(xData);
+        int yScreen = p.projY(yData);
         for (size_t ixT = 0; ixT < drawJobs.size(); ++ixT)
-            if (drawJobs[ixT].findClosestPoint(xScreen, yScreen, p, ixPt, bestDist)) {
+            if (visible[ixT] && drawJobs[ixT].findClosestPoint(xScreen, yScreen, p, ixPt, bestDist)) {
                 r = true;
                 ixTrace = ixT;
                 if (bestDist == 0)
@@ -88,11 +258,16 @@ class allDrawJobs_cl {
         return r;
     }
 
-    void getPt(size_t ixTrace, size_t ixPt, float& x, float& y) {
+    void getPt(size_t ixTrace, size_t ixPt, double& x, double& y) {
         assert(ixTrace < drawJobs.size());
         drawJobs[ixTrace].getPt(ixPt, x, y);
     }
 
+    void getPtResolution(size_t ixTrace, size_t ixPt, double& resX, double& resY) {
+        assert(ixTrace < drawJobs.size());
+        drawJobs[ixTrace].getPtResolution(ixPt, resX, resY);
+    }
+
     // returns all annotations for a given point on a given trace
     vector<string> getAnnotations(size_t ixTrace, size_t ixPt) const {
         assert(ixTrace < drawJobs.size());
@@ -100,5 +275,465 @@ class allDrawJobs_cl {
     }
 
    protected:
-    vector<drawJob> drawJobs;
+    // (deque: background tasks refer to elements)
+    std::deque<drawJob> drawJobs;
+    // per drawJob: hidden traces are not drawn and cannot be selected by the cursor (note: read from annotator thread)
+    std::deque<std::atomic<bool>> visible;
+
+    // per drawJob: pre-scaled point coordinates for the current zoom level (see drawJob::pixCoords_cl), computed in the background once the view is panned
+    class panCache_cl {
+       public:
+        ~panCache_cl() {
+            cancel = true;  // (then, the destructor of 'pending' waits for the build to end)
+        }
+        drawJob::pixCoords_cl coords;
+        std::future<drawJob::pixCoords_cl> pending;
+        proj<double> pendingProj;
+        std::atomic<bool> cancel = false;
+        // whether the trace gets a pan cache (see assignPanCacheBudgets)
+        bool inBudget = false;
+    };
+    // (declared after drawJobs, therefore destroyed first)
+    std::deque<panCache_cl> panCaches;
+    bool panCacheEnabled = false;
+    // view of the previous frame
+    proj<double> lastProj;
+    bool hasLastProj = false;
+
+    // gives pan caches to the traces, smallest first, within a budget of the memory of all X/Y data (the caches at most double it).
+    // The largest traces that don't fit are always rendered from data. A trace that drops out (e.g. grown by appended data) loses its cache
+    void assignPanCacheBudgets() {
+        size_t budget = 0;
+        vector<std::pair<size_t, size_t>> candidates;  // (pan cache bytes, ixJob)
+        for (size_t ixJob = 0; ixJob < drawJobs.size(); ++ixJob) {
+            const drawJob& j = drawJobs[ixJob];
+            budget += j.getDataBytes();
+            if (panCacheEnabled && j.hasPoints() && (j.getMode() != drawJob::LINES))
+                candidates.emplace_back(2 * sizeof(int32_t) * j.getNPoints(), ixJob);
+        }
+        std::sort(candidates.begin(), candidates.end());
+
+        vector<bool> inBudget(drawJobs.size(), false);
+        size_t nBytes = 0;
+        for (const auto& [nBytesJob, ixJob] : candidates) {
+            if (nBytes + nBytesJob > budget)
+                break;
+            nBytes += nBytesJob;
+            inBudget[ixJob] = true;
+        }
+
+        for (size_t ixJob = 0; ixJob < drawJobs.size(); ++ixJob) {
+            panCache_cl& c = panCaches[ixJob];
+            if (c.inBudget && !inBudget[ixJob]) {
+                c.cancel = true;
+                if (c.pending.valid())
+                    c.pending.wait();
+                c.pending = std::future<drawJob::pixCoords_cl>();
+                c.cancel = false;
+                c.coords = drawJob::pixCoords_cl();
+                drawJobs[ixJob].usePixCoords(NULL);
+            }
+            c.inBudget = inBudget[ixJob];
+        }
+    }
+
+    // collects finished pan caches and hands them to the drawJobs. While the view is panned at a zoom level without pan cache, starts building one in the background.
+    void updatePanCaches(const proj<double>& projStencil) {
+        const bool isPan = hasLastProj && drawJob::pixCoords_cl::isPan(lastProj, projStencil);
+        lastProj = projStencil;
+        hasLastProj = true;
+        for (size_t ixJob = 0; ixJob < drawJobs.size(); ++ixJob) {
+            drawJob& j = drawJobs[ixJob];
+            panCache_cl& c = panCaches[ixJob];
+            j.usePixCoords(NULL);
+            if (!c.inBudget)
+                continue;
+
+            // === collect finished build ===
+            if (c.pending.valid() && (c.pending.wait_for(std::chrono::seconds(0)) == std::future_status::ready))
+                c.coords = c.pending.get();
+
+            int64_t dx, dy;
+            if (c.coords.getOffset(projStencil, dx, dy)) {
+                j.usePixCoords(&c.coords);
+                continue;
+            }
+
+            if (c.pending.valid()) {
+                // === build in progress: abandon if it is for another zoom level ===
+                if (!drawJob::pixCoords_cl::isPan(c.pendingProj, projStencil))
+                    c.cancel = true;
+                continue;
+            }
+
+            // === start build (only while panning) ===
+            if (!isPan)
+                continue;
+            c.coords = drawJob::pixCoords_cl();  // free memory of the previous zoom level
+            c.cancel = false;
+            c.pendingProj = projStencil;
+            const drawJob* pJob = &j;
+            const std::atomic<bool>* pCancel = &c.cancel;
+            c.pending = std::async(std::launch::async, [pJob, projStencil, pCancel]() { return pJob->buildPixCoords(projStencil, *pCancel); });
+        }
+    }
+
+    // rendered points of each trace (before convolution) for one view, as list of hit pixels
+    class layerCache_cl {
+       public:
+        // whether the cache state (layers or "over budget") belongs to given stencil projection (= view)
+        bool isValidFor(const proj<double>& p) const {
+            return valid && sameView(p, key);
+        }
+
+        static bool sameView(const proj<double>& a, const proj<double>& b) {
+            return (a.getDataX0() == b.getDataX0()) && (a.getDataX1() == b.getDataX1()) && (a.getDataY0() == b.getDataY0()) && (a.getDataY1() == b.getDataY1()) && (a.getScreenWidth() == b.getScreenWidth()) && (a.getScreenHeight() == b.getScreenHeight());
+        }
+
+        // whether layers for given stencil projection are available
+        bool hasLayersFor(const proj<double>& p) const {
+            return isValidFor(p) && !overBudget;
+        }
+
+        void clear() {
+            valid = false;
+            overBudget = false;
+            hitsByJob.clear();
+            rgbaLayerByJob.clear();
+        }
+
+        void set(const proj<double>& p, vector<vector<uint32_t>>& hitsByJob, vector<vector<uint32_t>>& rgbaLayerByJob) {
+            key = p;
+            this->hitsByJob.swap(hitsByJob);
+            this->rgbaLayerByJob.swap(rgbaLayerByJob);
+            valid = true;
+            overBudget = false;
+        }
+
+        // RGBA layer of a trace with per-pixel color
+        const vector<uint32_t>& getRgbaLayer(size_t ixJob) const {
+            return rgbaLayerByJob[ixJob];
+        }
+
+        // flags that layers for this view would exceed the memory budget (don't retry until the view changes)
+        void setOverBudget(const proj<double>& p) {
+            clear();
+            key = p;
+            valid = true;
+            overBudget = true;
+        }
+
+        // writes the layer ID of each given trace to its hit pixels, in drawing order (same output as allDrawJobs_cl::renderIdBuf)
+        void composite(const vector<size_t>& ixJobs, vector<vector<layerId_t>>& idBufs) const {
+            idBufs.resize(1);
+            idBufs[0].assign((size_t)key.getScreenWidth() * key.getScreenHeight(), 0);
+            layerId_t* pIdBuf = idBufs[0].data();
+            for (size_t ixJob : ixJobs) {
+                const layerId_t id = (layerId_t)(ixJob + 1);
+                for (uint32_t ixPix : hitsByJob[ixJob])
+                    pIdBuf[ixPix] = id;
+            }
+        }
+
+       protected:
+        bool valid = false;
+        bool overBudget = false;
+        proj<double> key;
+        vector<vector<uint32_t>> hitsByJob;
+        // only for traces with per-pixel color (see drawJob::hasPerPixelColor)
+        vector<vector<uint32_t>> rgbaLayerByJob;
+    } layerCache;
+
+    // layerCache is rebuilt whenever the view changes (set on first use of trace visibility)
+    bool layerCacheEnabled = false;
+
+    // per marker shape: the ID buffer of the last frame before convolution (without per-pixel color traces), for a frame that adds appended points only
+    class idBufCache_cl {
+       public:
+        // whether the last frame had the same view and traces by shape
+        bool isAppendOf(const proj<double>& p, const vector<vector<size_t>>& ixJobsByShape) const {
+            return valid && layerCache_cl::sameView(p, key) && (ixJobsByShape == this->ixJobsByShape);
+        }
+
+        void set(const proj<double>& p, const vector<vector<size_t>>& ixJobsByShape) {
+            key = p;
+            this->ixJobsByShape = ixJobsByShape;
+            idBufByShape.assign(ixJobsByShape.size(), vector<layerId_t>());
+            valid = true;
+        }
+
+        void clear() {
+            valid = false;
+            idBufByShape.clear();
+        }
+
+        // points per trace in idBufByShape
+        vector<size_t> nPointsByJob;
+        vector<vector<layerId_t>> idBufByShape;
+
+       protected:
+        bool valid = false;
+        proj<double> key;
+        vector<vector<size_t>> ixJobsByShape;
+    } idBufCache;
+
+    // idBufCache is kept (set once data is appended, see replaceDrawJob, until a full redraw without appended data)
+    bool keepIdBufs = false;
+    // data was appended since the last frame
+    bool appendedSinceFrame = false;
+
+    // stops keeping the ID buffers of the last frame, and frees them
+    void clearIdBufCache() {
+        idBufCache.clear();
+        keepIdBufs = false;
+    }
+
+    // renders every trace (including hidden ones) into its own layer, unless memory use would exceed the budget
+    void buildLayerCache(const proj<double>& projStencil) {
+        const size_t nPix = (size_t)projStencil.getScreenWidth() * projStencil.getScreenHeight();
+        if (nPix > std::numeric_limits<uint32_t>::max()) {
+            layerCache.setOverBudget(projStencil);
+            return;
+        }
+        const size_t maxNHits = ((size_t)256 << 20) / sizeof(uint32_t);
+
+        // === traces with per-pixel color ===
+        vector<vector<uint32_t>> hitsByJob(drawJobs.size());
+        vector<vector<uint32_t>> rgbaLayerByJob(drawJobs.size());
+        std::atomic<size_t> nHits(0);
+        for (size_t ixJob = 0; ixJob < drawJobs.size(); ++ixJob) {
+            if (!drawJobs[ixJob].hasPerPixelColor())
+                continue;
+            if (nHits >= maxNHits)
+                break;
+            vector<uint32_t>& layer = rgbaLayerByJob[ixJob];
+            layer = renderRgbaLayer(drawJobs[ixJob], projStencil);
+            vector<uint32_t>& hits = hitsByJob[ixJob];
+            for (size_t ixPix = 0; ixPix < nPix; ++ixPix)
+                if (layer[ixPix])
+                    hits.push_back(ixPix);
+            nHits += hits.size() + nPix;
+        }
+
+        // === list all chunks ===
+        vector<std::pair<size_t, size_t>> ixJobIxChunk;
+        for (size_t ixJob = 0; ixJob < drawJobs.size(); ++ixJob)
+            if (!drawJobs[ixJob].hasPerPixelColor())
+                for (size_t ixChunk = 0; ixChunk < drawJobs[ixJob].getNChunks(); ++ixChunk)
+                    ixJobIxChunk.push_back({ixJob, ixChunk});
+
+        // === render chunks in parallel, each thread with its own scratch buffer ===
+        vector<vector<uint32_t>> hitsByChunk(ixJobIxChunk.size());
+        std::atomic<size_t> ixNext(0);
+        auto worker = [this, &ixJobIxChunk, &hitsByChunk, &ixNext, &nHits, &projStencil, nPix, maxNHits]() {
+            vector<uint8_t> scratch(nPix);
+            while (nHits < maxNHits) {
+                size_t ix = ixNext++;
+                if (ix >= ixJobIxChunk.size())
+                    return;
+                vector<uint32_t>& hits = hitsByChunk[ix];
+                drawJobs[ixJobIxChunk[ix].first].drawChunk(ixJobIxChunk[ix].second, projStencil, drawJob::pixOpCollect(scratch, /*out*/ hits));
+                for (uint32_t ixPix : hits)
+                    scratch[ixPix] = 0;
+                nHits += hits.size();
+            }
+        };
+        size_t nThreads = std::max(std::thread::hardware_concurrency(), 1u);
+        nThreads = std::max(std::min(nThreads, ixJobIxChunk.size()), (size_t)1);
+        vector<std::future<void>> futs;
+        for (size_t ixThread = 1; ixThread < nThreads; ++ixThread)
+            futs.push_back(std::async(worker));
+        worker();
+        for (std::future<void>& f : futs)
+            f.get();
+        if (nHits >= maxNHits) {
+            layerCache.setOverBudget(projStencil);  // render directly from data
+            return;
+        }
+
+        // === concatenate chunks per trace ===
+        for (size_t ix = 0; ix < ixJobIxChunk.size(); ++ix) {
+            vector<uint32_t>& dest = hitsByJob[ixJobIxChunk[ix].first];
+            dest.insert(dest.end(), hitsByChunk[ix].begin(), hitsByChunk[ix].end());
+        }
+        layerCache.set(projStencil, hitsByJob, rgbaLayerByJob);
+    }
+
+    // renders all chunks of the given drawJobs (from ixFirstChunkByJob) into one ID buffer per thread. Each buffer holds the highest layer ID that hit a pixel.
+    // Threads pick chunks in drawing order, therefore a thread never overwrites a higher ID with a lower one.
+    void renderIdBuf(const vector<size_t>& ixJobs, const proj<double>& projStencil, vector<vector<layerId_t>>& idBufs, const vector<size_t>& ixFirstChunkByJob) const {
+        const size_t nPix = (size_t)projStencil.getScreenWidth() * projStencil.getScreenHeight();
+
+        // === list all chunks ===
+        // (traces with per-pixel color are not included. Their RGBA layer needs to be combined later)
+        vector<std::pair<size_t, size_t>> ixJobIxChunk;
+        for (size_t ixJob : ixJobs)
+            if (!drawJobs[ixJob].hasPerPixelColor())
+                for (size_t ixChunk = ixFirstChunkByJob[ixJob]; ixChunk < drawJobs[ixJob].getNChunks(); ++ixChunk)
+                    ixJobIxChunk.push_back({ixJob, ixChunk});
+
+        // === one ID buffer per thread (limited by memory budget) ===
+        const size_t memBudget = (size_t)256 << 20;
+        size_t nThreads = std::max(std::thread::hardware_concurrency(), 1u);
+        nThreads = std::min(nThreads, memBudget / (nPix * sizeof(layerId_t)));
+        nThreads = std::max(std::min(nThreads, ixJobIxChunk.size()), (size_t)1);
+        idBufs.resize(nThreads);
+        for (vector<layerId_t>& idBuf : idBufs)
+            idBuf.assign(nPix, 0);
+
+        std::atomic<size_t> ixNext(0);
+        auto worker = [this, &ixJobIxChunk, &ixNext, &projStencil](vector<layerId_t>* pIdBuf) {
+            while (true) {
+                size_t ix = ixNext++;
+                if (ix >= ixJobIxChunk.size())
+                    return;
+                size_t ixJob = ixJobIxChunk[ix].first;
+                drawJobs[ixJob].drawChunk(ixJobIxChunk[ix].second, projStencil, drawJob::pixOpWriteId(/*out*/ *pIdBuf, /*layer ID*/ (layerId_t)(ixJob + 1)));
+            }
+        };
+        vector<std::future<void>> futs;
+        for (size_t ixThread = 1; ixThread < nThreads; ++ixThread)
+            futs.push_back(std::async(worker, &idBufs[ixThread]));
+        worker(idBufs.data());
+        for (std::future<void>& f : futs)
+            f.get();
+    }
+
+    // renders a trace with per-pixel color (see drawJob::hasPerPixelColor) into an RGBA layer
+    vector<uint32_t> renderRgbaLayer(const drawJob& j, const proj<double>& projStencil) const {
+        const int width = projStencil.getScreenWidth();
+        const int height = projStencil.getScreenHeight();
+        vector<uint32_t> rgba((size_t)width * height);
+        switch (j.getMode()) {
+            case drawJob::DENSITY: {
+                // === hit counts, summed over threads ===
+                vector<uint32_t> counts = renderPixBuf<uint32_t>(
+                    j, projStencil, [](vector<uint32_t>& buf) { return drawJob::pixOpCount(buf); }, [](uint32_t a, uint32_t b) { return a + b; });
+
+                // === map to colors ===
+                const uint32_t maxCount = *std::max_element(counts.begin(), counts.end());
+                parallelRows(height, [&counts, &rgba, &j, maxCount, width](int rowBegin, int rowEnd) {
+                    drawJob::drawCounts2rgba(counts, maxCount, j.getColormap(), /*out*/ rgba, (size_t)rowBegin * width, (size_t)rowEnd * width);
+                });
+                break;
+            }
+            case drawJob::COLORDATA: {
+                // === last point in data order per pixel (highest index wins across threads) ===
+                auto maxOp = [](uint32_t a, uint32_t b) { return std::max(a, b); };
+                const vector<uint32_t>* pPerm = j.getPerm();
+                vector<uint32_t> ixBuf = pPerm ? renderPixBuf<uint32_t>(j, projStencil, [pPerm](vector<uint32_t>& buf) { return drawJob::pixOpMaxPointIndex(buf, *pPerm); }, maxOp)
+                                               : renderPixBuf<uint32_t>(j, projStencil, [](vector<uint32_t>& buf) { return drawJob::pixOpWritePointIndex(buf); }, maxOp);
+
+                // === marker convolution: later points stay on top ===
+                vector<uint32_t> ixBufConv(ixBuf.size());
+                parallelRows(height, [&ixBuf, &ixBufConv, &j, width, height](int rowBegin, int rowEnd) {
+                    drawJob::dilateIdBuf(ixBuf, width, height, j.marker, /*out*/ ixBufConv, rowBegin, rowEnd);
+                });
+
+                // === map to colors ===
+                parallelRows(height, [&ixBufConv, &rgba, &j, width](int rowBegin, int rowEnd) {
+                    j.drawPointIndex2rgba(ixBufConv, /*out*/ rgba, (size_t)rowBegin * width, (size_t)rowEnd * width);
+                });
+                break;
+            }
+            case drawJob::CATEGORICAL: {
+                // === categories present per pixel (one bit each) ===
+                vector<uint64_t> bits = renderPixBuf<uint64_t>(
+                    j, projStencil, [&j](vector<uint64_t>& buf) { return drawJob::pixOpSetCategoryBit(buf, j); }, [](uint64_t a, uint64_t b) { return a | b; });
+
+                // === group categories by marker shape ===
+                const vector<const marker_cl*>& markers = j.getCategoryMarkers();
+                vector<const marker_cl*> shapes;
+                vector<uint64_t> bitsByShape;
+                for (size_t ixBit = 0; ixBit < markers.size(); ++ixBit) {
+                    size_t ixShape = 0;
+                    while ((ixShape < shapes.size()) && !shapes[ixShape]->sameShape(*markers[ixBit]))
+                        ++ixShape;
+                    if (ixShape == shapes.size()) {
+                        shapes.push_back(markers[ixBit]);
+                        bitsByShape.push_back(0);
+                    }
+                    bitsByShape[ixShape] |= (uint64_t)1 << ixBit;
+                }
+
+                // === per shape: topmost category per pixel, convolve (the highest category covering a pixel wins) ===
+                vector<uint8_t> topCat(bits.size());
+                vector<uint8_t> topCatConv(bits.size());
+                for (size_t ixShape = 0; ixShape < shapes.size(); ++ixShape) {
+                    parallelRows(height, [&bits, &topCat, &bitsByShape, ixShape, width](int rowBegin, int rowEnd) {
+                        for (size_t ix = (size_t)rowBegin * width; ix < (size_t)rowEnd * width; ++ix)
+                            topCat[ix] = drawJob::topCategory(bits[ix] & bitsByShape[ixShape]);
+                    });
+                    parallelRows(height, [&topCat, &topCatConv, &shapes, ixShape, width, height](int rowBegin, int rowEnd) {
+                        drawJob::dilateIdBuf(topCat, width, height, shapes[ixShape], /*out*/ topCatConv, rowBegin, rowEnd);
+                    });
+                }
+
+                // === map to colors ===
+                vector<uint32_t> rgbaByTopCat{/*none: transparent*/ 0};
+                for (const marker_cl* m : markers)
+                    rgbaByTopCat.push_back(m->rgba);
+                parallelRows(height, [&topCatConv, &rgba, &rgbaByTopCat, width](int rowBegin, int rowEnd) {
+                    for (size_t ix = (size_t)rowBegin * width; ix < (size_t)rowEnd * width; ++ix)
+                        rgba[ix] = rgbaByTopCat[topCatConv[ix]];
+                });
+                break;
+            }
+            default:
+                assert(false);
+        }
+        return rgba;
+    }
+
+    // renders all chunks of a trace into a buffer per thread (limited by memory budget), using the pixel operation from makePixOp(buffer). Then merges the buffers with mergeOp
+    template <typename pix_t, typename makePixOp_t, typename mergeOp_t>
+    static vector<pix_t> renderPixBuf(const drawJob& j, const proj<double>& projStencil, makePixOp_t makePixOp, mergeOp_t mergeOp) {
+        const int width = projStencil.getScreenWidth();
+        const int height = projStencil.getScreenHeight();
+        const size_t nPix = (size_t)width * height;
+        const size_t nChunks = j.getNChunks();
+
+        const size_t memBudget = (size_t)256 << 20;
+        size_t nThreads = std::max(std::thread::hardware_concurrency(), 1u);
+        nThreads = std::min(nThreads, memBudget / (nPix * sizeof(pix_t)));
+        nThreads = std::max(std::min(nThreads, nChunks), (size_t)1);
+        vector<vector<pix_t>> bufs(nThreads, vector<pix_t>(nPix));
+
+        std::atomic<size_t> ixNext(0);
+        auto worker = [&j, &ixNext, &projStencil, &makePixOp, nChunks](vector<pix_t>* pBuf) {
+            while (true) {
+                size_t ixChunk = ixNext++;
+                if (ixChunk >= nChunks)
+                    return;
+                j.drawChunk(ixChunk, projStencil, makePixOp(/*out*/ *pBuf));
+            }
+        };
+        vector<std::future<void>> futs;
+        for (size_t ixThread = 1; ixThread < nThreads; ++ixThread)
+            futs.push_back(std::async(worker, &bufs[ixThread]));
+        worker(bufs.data());
+        for (std::future<void>& f : futs)
+            f.get();
+
+        // === combine per-thread results ===
+        parallelRows(height, [&bufs, &mergeOp, width](int rowBegin, int rowEnd) {
+            for (size_t ixBuf = 1; ixBuf < bufs.size(); ++ixBuf)
+                for (size_t ix = (size_t)rowBegin * width; ix < (size_t)rowEnd * width; ++ix)
+                    bufs[0][ix] = mergeOp(bufs[0][ix], bufs[ixBuf][ix]);
+        });
+        return std::move(bufs[0]);
+    }
+
+    // runs fn(rowBegin, rowEnd) in parallel on blocks of rows 0..height-1
+    template <typename fn_t>
+    static void parallelRows(int height, fn_t fn) {
+        const int nThreads = std::max(std::thread::hardware_concurrency(), 1u);
+        const int nRowsPerBlock = std::max((height + nThreads - 1) / nThreads, 1);
+        vector<std::future<void>> futs;
+        for (int rowBegin = nRowsPerBlock; rowBegin < height; rowBegin += nRowsPerBlock)
+            futs.push_back(std::async(fn, rowBegin, std::min(rowBegin + nRowsPerBlock, height)));
+        fn(0, std::min(nRowsPerBlock, height));
+        for (std::future<void>& f : futs)
+            f.get();
+    }
 };
\ No newline at end of file
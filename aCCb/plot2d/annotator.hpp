@@ -14,7 +14,7 @@ class annotator_t {
         bgTask = std::async(backgroundProcessWrapper, this);
     }
 
-    void notifyCursorChange(double dataX, double dataY, proj<float>& p) {
+    void notifyCursorChange(double dataX, double dataY, proj<double>& p) {
         this->p = p;  // make a copy
         std::unique_lock<std::mutex> lock(mtx);
         mtState.cursorDataX = dataX;
@@ -23,6 +23,11 @@ class annotator_t {
         cv.notify_one();
     }
 
+    // holds off point lookup while the caller changes trace data (lookup reads allDrawJobs)
+    std::unique_lock<std::mutex> lockData() {
+        return std::unique_lock<std::mutex>(dataMtx);
+    }
+
     bool getHighlightedPoint(size_t& ixTrace, size_t& ixPt) {
         std::unique_lock<std::mutex> lock(mtx);
         // if (mtState.trigger != mtState.lastTrigger)
@@ -58,9 +63,9 @@ class annotator_t {
         int trigger = 0;
         int lastTrigger = 0;
         // input: cursor position
-        float cursorDataX = std::numeric_limits<float>::infinity();
+        double cursorDataX = std::numeric_limits<double>::infinity();
         // input: cursor position
-        float cursorDataY = std::numeric_limits<float>::infinity();
+        double cursorDataY = std::numeric_limits<double>::infinity();
         // flag to shut down worker thread
         int keepRunning = 1;
         // flags a valid result (trigger/lastTrigger tells whether it is in sync with the last request)
@@ -92,7 +97,10 @@ class annotator_t {
                 // Note: The perceived delay will be twice this amount, as the first trigger happens when the mouse moves a single pixel,
                 // usually returning the original point and showing no change.
                 // usleep(1e6); // needs <unistd.h>
-                stateCopy.resultIsValid = adj.findClosestPoint((float)stateCopy.cursorDataX, (float)stateCopy.cursorDataY, p, /*out*/ stateCopy.ixTrace, /*out*/ stateCopy.ixPt);
+                {
+                    std::unique_lock<std::mutex> lock(dataMtx);
+                    stateCopy.resultIsValid = adj.findClosestPoint(stateCopy.cursorDataX, stateCopy.cursorDataY, p, /*out*/ stateCopy.ixTrace, /*out*/ stateCopy.ixPt);
+                }
 
                 {  // lock
                     std::unique_lock<std::mutex> lock(mtx);
@@ -124,8 +132,10 @@ class annotator_t {
     }
 
     const allDrawJobs_cl& adj;
-    proj<float> p;
+    proj<double> p;
     std::mutex mtx;
+    // held during point lookup (see lockData)
+    std::mutex dataMtx;
     std::condition_variable cv;
     std::future<void> bgTask;
     bool isShutdown = false;
@@ -0,0 +1,92 @@
+#pragma once
+#include <algorithm>  // min, max
+#include <array>
+#include <cmath>  // log
+#include <cstdint>
+#include <string>
+#include <vector>
+using std::string, std::vector;
+
+// maps a value in 0..1 to RGBA (same byte order as marker_cl::rgba: red in the lowest byte, alpha 0xFF)
+class colormap_cl {
+   public:
+    static const int nEntries = 256;
+
+    // returns colormap by name or NULL if unknown
+    static const colormap_cl* get(const string& name) {
+        static const colormap_cl viridis({{0.000, 0x44, 0x01, 0x54}, {0.250, 0x3b, 0x52, 0x8b}, {0.500, 0x21, 0x91, 0x8c}, {0.750, 0x5e, 0xc9, 0x62}, {1.000, 0xfd, 0xe7, 0x25}});
+        static const colormap_cl hot({{0.000, 0x50, 0x00, 0x00}, {0.375, 0xff, 0x00, 0x00}, {0.750, 0xff, 0xff, 0x00}, {1.000, 0xff, 0xff, 0xff}});
+        static const colormap_cl jet({{0.000, 0x00, 0x00, 0x8f}, {0.125, 0x00, 0x00, 0xff}, {0.375, 0x00, 0xff, 0xff}, {0.625, 0xff, 0xff, 0x00}, {0.875, 0xff, 0x00, 0x00}, {1.000, 0x80, 0x00, 0x00}});
+        static const colormap_cl gray({{0.000, 0x40, 0x40, 0x40}, {1.000, 0xff, 0xff, 0xff}});
+        if (name == "viridis") return &viridis;
+        if (name == "hot") return &hot;
+        if (name == "jet") return &jet;
+        if (name == "gray") return &gray;
+        return NULL;
+    }
+
+    // list of valid names (for messages)
+    static string getNames() {
+        return "viridis hot jet gray";
+    }
+
+    // v in 0..1 (clipped) to RGBA
+    inline uint32_t rgba(float v) const {
+        int ix = (int)(v * (nEntries - 1) + 0.5f);
+        ix = std::min(std::max(ix, 0), nEntries - 1);
+        return table[ix];
+    }
+
+    // table entry to RGBA
+    inline uint32_t rgbaByIndex(int ix) const {
+        return table[ix];
+    }
+
+    // converts a hit count to RGBA on a logarithmic scale (1..maxCount). Zero count is transparent
+    class logScale_cl {
+       public:
+        logScale_cl(const colormap_cl* cm, uint32_t maxCount) : cm(cm), scale(maxCount > 1 ? 1.0f / std::log((float)maxCount) : 0.0f) {
+            // precompute the frequent small counts
+            lut[0] = 0;
+            for (uint32_t c = 1; c < lut.size(); ++c)
+                lut[c] = cm->rgba(std::log((float)c) * scale);
+        }
+        inline uint32_t operator()(uint32_t count) const {
+            if (count < lut.size())
+                return lut[count];
+            return cm->rgba(std::log((float)count) * scale);
+        }
+
+       protected:
+        const colormap_cl* cm;
+        float scale;
+        std::array<uint32_t, 4096> lut;
+    };
+
+   protected:
+    struct controlPoint_t {
+        double pos;
+        int r;
+        int g;
+        int b;
+    };
+
+    // linear interpolation between control points (sorted by pos, first at 0, last at 1)
+    colormap_cl(const vector<controlPoint_t>& cp) {
+        size_t ixCp = 0;
+        for (int ix = 0; ix < nEntries; ++ix) {
+            double pos = (double)ix / (nEntries - 1);
+            while ((ixCp + 2 < cp.size()) && (pos > cp[ixCp + 1].pos))
+                ++ixCp;
+            const controlPoint_t& a = cp[ixCp];
+            const controlPoint_t& b = cp[ixCp + 1];
+            double w = std::min(std::max((pos - a.pos) / (b.pos - a.pos), 0.0), 1.0);
+            uint32_t r = (uint32_t)(a.r + w * (b.r - a.r) + 0.5);
+            uint32_t g = (uint32_t)(a.g + w * (b.g - a.g) + 0.5);
+            uint32_t bl = (uint32_t)(a.b + w * (b.b - a.b) + 0.5);
+            table[ix] = 0xFF000000 | (bl << 16) | (g << 8) | r;
+        }
+    }
+
+    std::array<uint32_t, nEntries> table;
+};
@@ -0,0 +1,494 @@
+#pragma once
+#include <algorithm>  // min
+#include <cassert>
+#include <cmath>      // isfinite, isnan
+#include <cstring>    // memcpy
+#include <cstdint>
+#include <future>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <vector>
+using std::vector;
+
+// one column of trace data (e.g. Y values of a data file), held once in its native element type.
+// Consumers that need another type convert on access, chunk by chunk (e.g. a float file used as data and as mask)
+// 64 bit data (e.g. int64 timestamps) may instead be held "rebased": float offsets from a double origin per chunk (see rebased).
+class column_cl {
+   public:
+    enum type_e { FLOAT,
+                  DOUBLE,
+                  INT8,
+                  UINT8,
+                  INT16,
+                  UINT16,
+                  INT32,
+                  UINT32,
+                  INT64,
+                  UINT64 };
+
+    column_cl() {}
+
+    // takes ownership of data
+    template <typename T>
+    explicit column_cl(vector<T>&& data) {
+        auto p = std::make_shared<vector<T>>(std::move(data));
+        type = getTypeOf<T>();
+        pData = p->data();
+        n = p->size();
+        owner = p;
+    }
+
+    // refers to n elements at p, kept valid by owner (e.g. a memory-mapped file)
+    template <typename T>
+    column_cl(const T* p, size_t n, std::shared_ptr<const void> owner) : type(getTypeOf<T>()), pData(p), n(n), owner(owner) {}
+
+    // refers to data without ownership (lifetime must exceed the column)
+    template <typename T>
+    static column_cl view(const vector<T>& data) {
+        column_cl r;
+        r.type = getTypeOf<T>();
+        r.pData = data.data();
+        r.n = data.size();
+        return r;
+    }
+
+    size_t size() const {
+        return n;
+    }
+
+    // the first n elements (shares the data, e.g. to match the length of another column)
+    column_cl head(size_t n) const {
+        column_cl r = *this;
+        r.n = std::min(n, this->n);
+        return r;
+    }
+
+    // element type (rebased: DOUBLE)
+    type_e getType() const {
+        return type;
+    }
+
+    template <typename T>
+    static constexpr type_e getTypeOf() {
+        if constexpr (std::is_same_v<T, float>)
+            return FLOAT;
+        else if constexpr (std::is_same_v<T, double>)
+            return DOUBLE;
+        else if constexpr (std::is_same_v<T, int8_t>)
+            return INT8;
+        else if constexpr (std::is_same_v<T, uint8_t>)
+            return UINT8;
+        else if constexpr (std::is_same_v<T, int16_t>)
+            return INT16;
+        else if constexpr (std::is_same_v<T, uint16_t>)
+            return UINT16;
+        else if constexpr (std::is_same_v<T, int32_t>)
+            return INT32;
+        else if constexpr (std::is_same_v<T, uint32_t>)
+            return UINT32;
+        else if constexpr (std::is_same_v<T, int64_t>)
+            return INT64;
+        else {
+            static_assert(std::is_same_v<T, uint64_t>, "unsupported column type");
+            return UINT64;
+        }
+    }
+
+    // native data if its element type is T, otherwise NULL (also if rebased)
+    template <typename T>
+    const T* getNative() const {
+        return ((type == getTypeOf<T>()) && !isRebased()) ? (const T*)pData : NULL;
+    }
+
+    // calls fn(p) with p pointing to the native data (not for rebased columns)
+    template <typename fn_t>
+    auto visit(fn_t fn) const {
+        assert(!isRebased());
+        switch (type) {
+            case DOUBLE:
+                return fn((const double*)pData);
+            case INT8:
+                return fn((const int8_t*)pData);
+            case UINT8:
+                return fn((const uint8_t*)pData);
+            case INT16:
+                return fn((const int16_t*)pData);
+            case UINT16:
+                return fn((const uint16_t*)pData);
+            case INT32:
+                return fn((const int32_t*)pData);
+            case UINT32:
+                return fn((const uint32_t*)pData);
+            case INT64:
+                return fn((const int64_t*)pData);
+            case UINT64:
+                return fn((const uint64_t*)pData);
+            case FLOAT:
+            default:
+                return fn((const float*)pData);
+        }
+    }
+
+    // memory held by the data in bytes (elements, rebased: offsets, quantized: also codes)
+    size_t getBytes() const {
+        size_t r = n * (isRebased() ? sizeof(float) : visit([](const auto* p) { return sizeof(*p); }));
+        if (isQuantized())
+            r += n * sizeof(uint16_t);
+        return r;
+    }
+
+    // v as type T. Floating point to integer: NAN gives 0, values out of range are clamped (a plain cast would be undefined)
+    template <typename T, typename S>
+    static T convertValue(S v) {
+        if constexpr (std::is_integral_v<T> && std::is_floating_point_v<S>) {
+            if (std::isnan(v))
+                return 0;
+            if (v <= (S)std::numeric_limits<T>::min())
+                return std::numeric_limits<T>::min();
+            if (v >= (S)std::numeric_limits<T>::max())  // (max may round up: then beyond the range)
+                return std::numeric_limits<T>::max();
+        }
+        return (T)v;
+    }
+
+    // elements ixBegin..ixEnd-1 as type T: points into the native data if the type matches, otherwise converts into buf
+    template <typename T>
+    const T* getChunk(size_t ixBegin, size_t ixEnd, vector<T>& buf) const {
+        if (const T* p = getNative<T>())
+            return p + ixBegin;
+        buf.resize(ixEnd - ixBegin);
+        T* pDest = buf.data();
+        if (isRebased()) {
+            const float* p = (const float*)pData;
+            for (size_t ix = ixBegin; ix < ixEnd; ++ix)
+                pDest[ix - ixBegin] = convertValue<T>(getOrigin(ix) + p[ix]);
+        } else
+            visit([pDest, ixBegin, ixEnd](const auto* p) {
+                for (size_t ix = ixBegin; ix < ixEnd; ++ix)
+                    pDest[ix - ixBegin] = convertValue<T>(p[ix]);
+            });
+        return pDest;
+    }
+
+    // calls fn(ixBegin, p, nElem) for consecutive chunks of all elements as type T (p: element ixBegin)
+    template <typename T, typename fn_t>
+    void forEachChunk(fn_t fn) const {
+        vector<T> buf;
+        for (size_t ixBegin = 0; ixBegin < n; ixBegin += chunkSize) {
+            const size_t ixEnd = std::min(ixBegin + chunkSize, n);
+            fn(ixBegin, getChunk<T>(ixBegin, ixEnd, buf), ixEnd - ixBegin);
+        }
+    }
+
+    // single element as type T
+    template <typename T>
+    T at(size_t ix) const {
+        if (isRebased())
+            return convertValue<T>(getOrigin(ix) + ((const float*)pData)[ix]);
+        return visit([ix](const auto* p) { return convertValue<T>(p[ix]); });
+    }
+
+    // spacing of the values around element ix as held (0: exact as double): float spacing for float and rebased data (offset), 1 for integers
+    double getResolution(size_t ix) const {
+        if (isRebased()) {
+            const float offset = std::fabs(((const float*)pData)[ix]);
+            return std::nextafter(offset, std::numeric_limits<float>::infinity()) - offset;
+        }
+        return visit([ix](const auto* p) -> double {
+            typedef std::remove_cv_t<std::remove_pointer_t<decltype(p)>> t_t;
+            if constexpr (std::is_same_v<t_t, float>) {
+                const float v = std::fabs(p[ix]);
+                return std::nextafter(v, std::numeric_limits<float>::infinity()) - v;
+            } else if constexpr (std::is_same_v<t_t, double>)
+                return 0.0;
+            else
+                return 1.0;
+        });
+    }
+
+    // all elements converted to type T (see getNative for no conversion)
+    template <typename T>
+    column_cl convert() const {
+        vector<T> r(n);
+        if (isRebased())
+            parallelChunks([this, &r](size_t, size_t ixBegin, size_t ixEnd) {
+                for (size_t ix = ixBegin; ix < ixEnd; ++ix)
+                    r[ix] = at<T>(ix);
+            });
+        else
+            visit([&r](const auto* p) {
+                for (size_t ix = 0; ix < r.size(); ++ix)
+                    r[ix] = convertValue<T>(p[ix]);
+            });
+        return column_cl(std::move(r));
+    }
+
+    // values are float offsets from an origin per chunk of chunkSize elements (see rebased)
+    bool isRebased() const {
+        return !origins.empty();
+    }
+
+    // values are relative to an origin per chunk (see getOrigin): rebased or quantized
+    bool hasOrigins() const {
+        return isRebased() || isQuantized();
+    }
+
+    // origin of the chunk holding element ix (0 if none, see hasOrigins)
+    double getOrigin(size_t ix) const {
+        if (isRebased())
+            return origins[ix / chunkSize];
+        return isQuantized() ? quantChunks[ix / chunkSize].origin : 0.0;
+    }
+
+    // copy as float offsets from the mid-range of each chunk (integral for integer data), for full precision near the origin at the memory cost of float.
+    // The offset is computed in the native type, therefore int64 data keeps its resolution also where double would not.
+    column_cl rebased() const {
+        if (isRebased())
+            return *this;
+        auto offsets = std::make_shared<vector<float>>(n);
+        column_cl r;
+        r.type = DOUBLE;
+        r.pData = offsets->data();
+        r.n = n;
+        r.owner = offsets;
+        r.origins.resize((n + chunkSize - 1) / chunkSize);
+        float* pOffsets = offsets->data();
+        double* pOrigins = r.origins.data();
+        visit([this, pOffsets, pOrigins](const auto* p) {
+            typedef std::remove_cv_t<std::remove_pointer_t<decltype(p)>> t_t;
+            parallelChunks([p, pOffsets, pOrigins](size_t ixChunk, size_t ixBegin, size_t ixEnd) {
+                const t_t origin = midRange(p, ixBegin, ixEnd);
+                pOrigins[ixChunk] = (double)origin;
+
+                // === offsets ===
+                for (size_t ix = ixBegin; ix < ixEnd; ++ix)
+                    pOffsets[ix] = (float)difference(p[ix], origin);
+            });
+        });
+        return r;
+    }
+
+    // as rebased(), for data that grows: extends prev, a copy of the first elements made by this function (empty for a start).
+    // Only the new elements are converted, into storage (moves to a larger one when full, prev keeps the old one). New elements in the last chunk of prev use its origin
+    column_cl rebasedExtended(const column_cl& prev, std::shared_ptr<vector<float>>& storage) const {
+        assert(!isRebased() && (prev.isRebased() || (prev.size() == 0)) && (prev.size() <= n));
+        const size_t nPrev = prev.size();
+        if (!storage || (storage->size() < n)) {
+            auto next = std::make_shared<vector<float>>(std::max(2 * n, (size_t)chunkSize));
+            if (nPrev)
+                memcpy(next->data(), prev.pData, nPrev * sizeof(float));
+            storage = next;
+        }
+        column_cl r;
+        r.type = DOUBLE;
+        r.pData = storage->data();
+        r.n = n;
+        r.owner = storage;
+        r.origins = prev.origins;
+        r.origins.resize((n + chunkSize - 1) / chunkSize);
+        float* pOffsets = storage->data();
+        visit([&r, pOffsets, nPrev, this](const auto* p) {
+            typedef std::remove_cv_t<std::remove_pointer_t<decltype(p)>> t_t;
+            for (size_t ixBegin = nPrev; ixBegin < n; ixBegin = (ixBegin / chunkSize + 1) * chunkSize) {
+                const size_t ixChunk = ixBegin / chunkSize;
+                const size_t ixEnd = std::min((ixChunk + 1) * chunkSize, n);
+                // === new chunk: origin from the elements that have arrived ===
+                if (ixBegin % chunkSize == 0)
+                    r.origins[ixChunk] = (double)midRange(p, ixBegin, ixEnd);
+                const t_t origin = (t_t)r.origins[ixChunk];
+                for (size_t ix = ixBegin; ix < ixEnd; ++ix)
+                    pOffsets[ix] = (float)difference(p[ix], origin);
+            }
+        });
+        return r;
+    }
+
+    // as convert<T>(), for data that grows: extends prev, a copy of the first elements made by this function or by convert<T>() (empty for a start). Only the new elements are converted.
+    // storage: as rebasedExtended
+    template <typename T>
+    column_cl convertedExtended(const column_cl& prev, std::shared_ptr<vector<T>>& storage) const {
+        assert(((prev.getNative<T>() != NULL) || (prev.size() == 0)) && (prev.size() <= n));
+        const size_t nPrev = prev.size();
+        if (!storage || (storage->size() < n) || (prev.pData != storage->data())) {
+            auto next = std::make_shared<vector<T>>(std::max(2 * n, (size_t)chunkSize));
+            if (nPrev)
+                memcpy(next->data(), prev.pData, nPrev * sizeof(T));
+            storage = next;
+        }
+        T* pDest = storage->data();
+        if (isRebased())
+            for (size_t ix = nPrev; ix < n; ++ix)
+                pDest[ix] = at<T>(ix);
+        else
+            visit([pDest, nPrev, this](const auto* p) {
+                for (size_t ix = nPrev; ix < n; ++ix)
+                    pDest[ix] = convertValue<T>(p[ix]);
+            });
+        return column_cl((const T*)pDest, n, storage);
+    }
+
+    // elements ixBegin..ixEnd-1 as float, relative to origin: points into the offsets if they use this origin, otherwise converts into buf
+    const float* getChunkRelative(size_t ixBegin, size_t ixEnd, double origin, vector<float>& buf) const {
+        if (!isRebased() && (origin == 0.0))
+            return getChunk<float>(ixBegin, ixEnd, buf);
+        if (isRebased() && (ixBegin < ixEnd) && (ixBegin / chunkSize == (ixEnd - 1) / chunkSize) && (getOrigin(ixBegin) == origin))
+            return (const float*)pData + ixBegin;
+        buf.resize(ixEnd - ixBegin);
+        float* pDest = buf.data();
+        if (isRebased()) {
+            const float* p = (const float*)pData;
+            for (size_t ix = ixBegin; ix < ixEnd; ++ix)
+                pDest[ix - ixBegin] = (float)((getOrigin(ix) - origin) + p[ix]);
+        } else
+            visit([pDest, ixBegin, ixEnd, origin](const auto* p) {
+                typedef std::remove_cv_t<std::remove_pointer_t<decltype(p)>> t_t;
+                if constexpr (std::is_integral_v<t_t>) {
+                    // === integral origin: exact difference in the native type ===
+                    if ((origin >= (double)std::numeric_limits<t_t>::lowest()) && (origin < (double)std::numeric_limits<t_t>::max()) && ((double)(t_t)origin == origin)) {
+                        for (size_t ix = ixBegin; ix < ixEnd; ++ix)
+                            pDest[ix - ixBegin] = (float)difference(p[ix], (t_t)origin);
+                        return;
+                    }
+                }
+                for (size_t ix = ixBegin; ix < ixEnd; ++ix)
+                    pDest[ix - ixBegin] = (float)((double)p[ix] - origin);
+            });
+        return pDest;
+    }
+
+    // copy with an additional 16 bit code per element, for rendering with half the memory traffic of float (see getCodes).
+    // Per chunk, the codes span the range of its values. Element access still reads the original data, e.g. a memory-mapped file (exact values for readout, masks)
+    column_cl quantized() const {
+        if (isRebased() || isQuantized())
+            return *this;
+        auto c = std::make_shared<vector<uint16_t>>(n);
+        column_cl r(*this);
+        r.codes = c;
+        r.quantChunks.resize((n + chunkSize - 1) / chunkSize);
+        uint16_t* pCodes = c->data();
+        quantChunk_t* pQuant = r.quantChunks.data();
+        visit([this, pCodes, pQuant](const auto* p) {
+            typedef std::remove_cv_t<std::remove_pointer_t<decltype(p)>> t_t;
+            parallelChunks([p, pCodes, pQuant](size_t ixChunk, size_t ixBegin, size_t ixEnd) {
+                // === range of finite values ===
+                t_t vMin = std::numeric_limits<t_t>::max();
+                t_t vMax = std::numeric_limits<t_t>::lowest();
+                bool allFinite = true;
+                for (size_t ix = ixBegin; ix < ixEnd; ++ix) {
+                    if (!std::isfinite((double)p[ix])) {
+                        allFinite = false;
+                        continue;
+                    }
+                    vMin = std::min(vMin, p[ix]);
+                    vMax = std::max(vMax, p[ix]);
+                }
+                if (vMin > vMax)
+                    return;  // (no finite value: origin 0)
+                // (origin must convert to double exactly: clear the bits below double precision)
+                t_t origin = vMin;
+                if constexpr (std::is_integral_v<t_t> && (sizeof(t_t) == 8))
+                    origin = vMin & ~(t_t)0x7FF;
+                const double range = difference(vMax, origin);
+                const double scale = (range > 0) ? 65535.0 / range : 0.0;
+                pQuant[ixChunk] = {(double)origin, (range > 0) ? range / 65535.0 : 1.0, allFinite};  // (constant: all codes 0)
+                if (!allFinite)
+                    return;  // no codes, origin only (see getOrigin)
+
+                // === codes ===
+                for (size_t ix = ixBegin; ix < ixEnd; ++ix)
+                    pCodes[ix] = (uint16_t)std::min(difference(p[ix], origin) * scale + 0.5, 65535.0);
+            });
+        });
+        return r;
+    }
+
+    // has codes (see quantized)
+    bool isQuantized() const {
+        return codes != NULL;
+    }
+
+    // codes of chunk ixChunk (element ixChunk * chunkSize), with value = origin + step * code. Returns false if the chunk has none (not quantized or non-finite values)
+    bool getCodes(size_t ixChunk, const uint16_t*& p, double& origin, double& step) const {
+        if (!isQuantized() || !quantChunks[ixChunk].valid)
+            return false;
+        p = codes->data() + ixChunk * chunkSize;
+        origin = quantChunks[ixChunk].origin;
+        step = quantChunks[ixChunk].step;
+        return true;
+    }
+
+    // number of elements per conversion in forEachChunk, and per origin of rebased data
+    static const size_t chunkSize = 65536;
+
+   protected:
+    type_e type = FLOAT;
+    // element 0 (rebased: float offsets)
+    const void* pData = NULL;
+    size_t n = 0;
+    // keeps pData valid (NULL: not owned)
+    std::shared_ptr<const void> owner;
+    // origin per chunk of rebased data (empty: not rebased)
+    vector<double> origins;
+    // codes of quantized data (NULL: none)
+    std::shared_ptr<const vector<uint16_t>> codes;
+    // per chunk of quantized data: value = origin + step * code
+    struct quantChunk_t {
+        double origin = 0;
+        double step = 0;
+        // false: chunk has no codes
+        bool valid = false;
+    };
+    vector<quantChunk_t> quantChunks;
+
+    // mid-range of the finite values p[ixBegin..ixEnd-1] (0 if none), as origin for rebasing.
+    // An integer origin must convert back exactly, then the subtraction in difference() is exact
+    template <typename T>
+    static T midRange(const T* p, size_t ixBegin, size_t ixEnd) {
+        T vMin = std::numeric_limits<T>::max();
+        T vMax = std::numeric_limits<T>::lowest();
+        for (size_t ix = ixBegin; ix < ixEnd; ++ix)
+            if (std::isfinite((double)p[ix])) {
+                vMin = std::min(vMin, p[ix]);
+                vMax = std::max(vMax, p[ix]);
+            }
+        if (vMin > vMax)
+            return 0;  // no finite data
+        const double mid = 0.5 * (double)vMin + 0.5 * (double)vMax;
+        if constexpr (std::is_integral_v<T>)
+            return ((mid > (double)vMin) && (mid < (double)vMax)) ? (T)mid : vMin;
+        else
+            return (T)mid;
+    }
+
+    // v - origin, exact for integers (also where the difference exceeds the signed range)
+    template <typename T>
+    static inline double difference(T v, T origin) {
+        if constexpr (std::is_integral_v<T>) {
+            typedef std::make_unsigned_t<T> u_t;
+            return (v >= origin) ? (double)(u_t)((u_t)v - (u_t)origin) : -(double)(u_t)((u_t)origin - (u_t)v);
+        } else
+            return (double)v - (double)origin;
+    }
+
+    // runs fn(ixChunk, ixBegin, ixEnd) for all chunks, in parallel on one group of chunks per thread
+    template <typename fn_t>
+    void parallelChunks(fn_t fn) const {
+        const size_t nChunks = (n + chunkSize - 1) / chunkSize;
+        const size_t nThreads = std::max(std::min((size_t)std::thread::hardware_concurrency(), nChunks), (size_t)1);
+        const size_t nChunksPerThread = (nChunks + nThreads - 1) / nThreads;
+        auto group = [this, &fn, nChunks, nChunksPerThread](size_t ixThread) {
+            const size_t ixChunkEnd = std::min((ixThread + 1) * nChunksPerThread, nChunks);
+            for (size_t ixChunk = ixThread * nChunksPerThread; ixChunk < ixChunkEnd; ++ixChunk)
+                fn(ixChunk, ixChunk * chunkSize, std::min((ixChunk + 1) * chunkSize, n));
+        };
+        vector<std::future<void>> futs;
+        for (size_t ixThread = 1; ixThread < nThreads; ++ixThread)
+            futs.push_back(std::async(std::launch::async, group, ixThread));
+        group(0);
+        for (std::future<void>& f : futs)
+            f.get();
+    }
+};
@@ -2,96 +2,500 @@
 #include <FL/Fl_Image.H>
 #include <FL/fl_draw.H>
 
+#include <algorithm>  // max
+#include <atomic>
 #include <cassert>
 #include <cmath>  // ceil
-#include <future>
+#include <limits>
 #include <string>
 #include <vector>
 
+#include "colormap.hpp"
+#include "column.hpp"
 #include "marker.hpp"
+#include "mortonOrder.hpp"
 #include "proj.hpp"
 using std::vector, std::string;
-// type held by the stencil. A single bit would be sufficient but the required read/bit masking/write completely kills performance.
-// benchmarking shows "byte" is fastest. This seems plausible, given that a typical memory hardware architecture supports byte-level masked write via dedicated "enable" lines
-typedef uint8_t stencil_t;  // bool: 32 ms; uint8: 4.5 ms; uint16: 6 ms uint32_t: 9 ms uint64_t: 16 ms
+// type held by the layer ID buffer: per pixel, the topmost trace (0: empty). Traces are rendered in a single pass, the ID decides about occlusion.
+// Stencil benchmarking showed "byte" fastest (bool: 32 ms; uint8: 4.5 ms; uint16: 6 ms uint32_t: 9 ms uint64_t: 16 ms). uint16 is the smallest type
+// that supports a practical number of traces.
+typedef uint16_t layerId_t;
 
 // one "trace" (set of things to be rendered using a common marker by convolution)
 class drawJob {
    public:
     class annotation_cl {
        public:
-        annotation_cl(const vector<uint32_t>* mapping, const vector<string>* annotText) : mapping(mapping), annotText(annotText) {}
-        const vector<uint32_t>* mapping;
+        annotation_cl(const column_cl* mapping, const vector<string>* annotText) : mapping(mapping), annotText(annotText) {}
+        const column_cl* mapping;
         const vector<string>* annotText;
     };
 
+    // how points of a trace are rendered
+    enum drawMode_e {
+        /** marker at each point */
+        DOTS,
+        /** per-pixel hit count, through a colormap on log scale. Single-pixel marker */
+        DENSITY,
+        /** marker at each point, colored by per-point data through a colormap. The last point in data order wins */
+        COLORDATA,
+        /** marker and color per point by category (mask value). Occlusion by category priority */
+        CATEGORICAL,
+        /** marker along straight lines between consecutive points */
+        LINES
+    };
+
+    // max. number of categories in CATEGORICAL mode (one bit per category in a uint64_t, bit 0 is used for lines)
+    static const size_t maxNCategories = 63;
+
+    // point index passed to pixel operations for lines
+    static const size_t ixPtLine = (size_t)-1;
+
+    // pixel operation for drawDots(): writes the layer ID
+    class pixOpWriteId {
+       public:
+        pixOpWriteId(vector<layerId_t>& idBuf, layerId_t id) : pIdBuf(idBuf.data()), id(id) {}
+        inline void operator()(size_t ixPix, size_t /*ixPt*/) const {
+            pIdBuf[ixPix] = id;
+        }
+
+       protected:
+        layerId_t* pIdBuf;
+        layerId_t id;
+    };
+
+    // pixel operation for drawDots(): lists each pixel that is hit (once). The caller needs to clear the scratch buffer afterwards, at the listed pixels.
+    class pixOpCollect {
+       public:
+        pixOpCollect(vector<uint8_t>& scratch, vector<uint32_t>& hits) : pScratch(scratch.data()), pHits(&hits) {}
+        inline void operator()(size_t ixPix, size_t /*ixPt*/) const {
+            if (!pScratch[ixPix]) {
+                pScratch[ixPix] = 1;
+                pHits->push_back(ixPix);
+            }
+        }
+
+       protected:
+        uint8_t* pScratch;
+        vector<uint32_t>* pHits;
+    };
+
+    // pixel operation for drawDots(): counts hits per pixel
+    class pixOpCount {
+       public:
+        pixOpCount(vector<uint32_t>& counts) : pCounts(counts.data()) {}
+        inline void operator()(size_t ixPix, size_t /*ixPt*/) const {
+            ++pCounts[ixPix];
+        }
+
+       protected:
+        uint32_t* pCounts;
+    };
+
+    // pixel operation for drawDots(): writes the point index + 2 (0: empty, 1: line). Since points are drawn in data order, the last writer wins.
+    // Buffers from parallel chunks combine by max.
+    class pixOpWritePointIndex {
+       public:
+        pixOpWritePointIndex(vector<uint32_t>& ixBuf) : pIxBuf(ixBuf.data()) {}
+        inline void operator()(size_t ixPix, size_t ixPt) const {
+            // note: ixPtLine + 2 wraps around to 1
+            pIxBuf[ixPix] = (uint32_t)(ixPt + 2);
+        }
+
+       protected:
+        uint32_t* pIxBuf;
+    };
+
+    // as pixOpWritePointIndex, for reordered data (see setReordered): writes the original point index + 2 if higher than the previous value
+    class pixOpMaxPointIndex {
+       public:
+        pixOpMaxPointIndex(vector<uint32_t>& ixBuf, const vector<uint32_t>& perm) : pIxBuf(ixBuf.data()), pPerm(perm.data()) {}
+        inline void operator()(size_t ixPix, size_t ixPt) const {
+            const uint32_t v = (ixPt == ixPtLine) ? 1 : pPerm[ixPt] + 2;
+            pIxBuf[ixPix] = std::max(pIxBuf[ixPix], v);
+        }
+
+       protected:
+        uint32_t* pIxBuf;
+        const uint32_t* pPerm;
+    };
+
+    // pixel operation for drawDots(): sets the bit of the point's category (bit 0: line. Categories outside the palette: none).
+    // Buffers from parallel chunks combine by OR.
+    class pixOpSetCategoryBit {
+       public:
+        pixOpSetCategoryBit(vector<uint64_t>& bitBuf, const drawJob& j)
+            : pBitBuf(bitBuf.data()), pCategory(j.pReordered ? j.pReordered->category.data() : j.pCategory->getNative<uint16_t>()), pBitByValue(j.categoryBitByValue.data()) {}
+        inline void operator()(size_t ixPix, size_t ixPt) const {
+            pBitBuf[ixPix] |= (ixPt == ixPtLine) ? 1 : pBitByValue[pCategory[ixPt]];
+        }
+
+       protected:
+        uint64_t* pBitBuf;
+        const uint16_t* pCategory;
+        const uint64_t* pBitByValue;
+    };
+
+    // pre-scaled screen coordinates of all points for one zoom level (fixed point). Panning needs only an integer offset instead of a multiply-add per point.
+    class pixCoords_cl {
+       public:
+        // fractional bits
+        static const int fracBits = 8;
+        // coordinates beyond this many pixels from the view are stored as 'farAway' (never on screen)
+        static constexpr double maxPix = 1 << 22;
+        // max. pan (pixels) from the view the coordinates were computed for
+        static constexpr double maxPan = 1 << 21;
+        static const int32_t farAway = std::numeric_limits<int32_t>::min() / 2;
+
+        // whether pNow differs from p only by a pan, within range of the coordinates
+        static bool isPan(const proj<double>& p, const proj<double>& pNow) {
+            double dx, dy;
+            return getPan(p, pNow, dx, dy);
+        }
+
+        // fixed point offset to convert coordinates to pNow. Returns false if not applicable (see isPan).
+        bool getOffset(const proj<double>& pNow, int64_t& dx, int64_t& dy) const {
+            double dxPix, dyPix;
+            if (!valid || !getPan(p, pNow, dxPix, dyPix))
+                return false;
+            dx = std::llround(dxPix * (1 << fracBits));
+            dy = std::llround(dyPix * (1 << fracBits));
+            return true;
+        }
+
+        static inline int32_t toFixed(double pix) {
+            if (!(std::abs(pix) < maxPix))
+                return farAway;  // includes NaN
+            return (int32_t)std::floor(pix * (1 << fracBits));
+        }
+
+        // the coordinates are complete (not cancelled)
+        bool valid = false;
+        // projection the coordinates were computed for
+        proj<double> p;
+        vector<int32_t> x;
+        vector<int32_t> y;
+
+       protected:
+        // pan in pixels from p to pNow. Scale must be the same (tolerance for rounding of the data range, see proj)
+        static bool getPan(const proj<double>& p, const proj<double>& pNow, double& dxPix, double& dyPix) {
+            const double relTol = 1e-5;
+            if ((p.getScreenWidth() != pNow.getScreenWidth()) || (p.getScreenHeight() != pNow.getScreenHeight()))
+                return false;
+            if (!(std::abs(pNow.getScaleX() - p.getScaleX()) <= relTol * std::abs(p.getScaleX())) || !(std::abs(pNow.getScaleY() - p.getScaleY()) <= relTol * std::abs(p.getScaleY())))
+                return false;
+            // === shift of the center of p ===
+            const double xc = 0.5 * (p.getDataX0() + p.getDataX1());
+            const double yc = 0.5 * (p.getDataY0() + p.getDataY1());
+            dxPix = pNow.projXf(xc) - p.projXf(xc);
+            dyPix = pNow.projYf(yc) - p.projYf(yc);
+            return (std::abs(dxPix) < maxPan) && (std::abs(dyPix) < maxPan);
+        }
+    };
+
    protected:
-    // multithreaded job description, for segmenting a trace with a large nr. of points into multiple "jobs" that are rendered to stencil in parallel
+    // multithreaded job description, for segmenting a trace with a large nr. of points into multiple "jobs" that are rendered to layer ID buffers in parallel
+    // X / Y data is read in its native type (tx_t, ty_t), the kernels convert to float per point for projection
     // note: passed by value - don't put anything large inside
+    template <typename tx_t, typename ty_t>
     class job_t {
        public:
-        job_t(size_t ixStart, size_t ixEnd, const vector<float>* pDataX, const vector<float>* pDataY, const proj<float> p, const vector<uint16_t>* pMask, uint16_t maskVal, vector<stencil_t>* pStencil)
+        // data pointers refer to point ixStart (pDataX, pMask may be NULL)
+        // without X data, X is implicit relative to ixStart: point ixStart is at X = 1 of p (see rebasedImplicitX)
+        job_t(size_t ixStart, size_t ixEnd, const tx_t* pDataX, const ty_t* pDataY, const proj<float> p, const uint16_t* pMask, uint16_t maskVal)
             : ixStart(ixStart),
               ixEnd(ixEnd),
               pDataX(pDataX),
               pDataY(pDataY),
               p(p),
               pMask(pMask),
-              maskVal(maskVal),
-              pStencil(pStencil) {
-            if ((pDataX != NULL) && (pDataY != NULL))
-                if (pDataX->size() != pDataY->size())
-                    throw std::runtime_error("inconsistent trace data size X/Y");
-        }
+              maskVal(maskVal) {}
 
         const size_t ixStart;
         const size_t ixEnd;
-        const vector<float>* pDataX;
-        const vector<float>* pDataY;
+        const tx_t* pDataX;
+        const ty_t* pDataY;
         const proj<float> p;
-        const vector<uint16_t>* pMask;
+        const uint16_t* pMask;
         uint16_t maskVal;
-        vector<stencil_t>* pStencil;
     };
 
-    // worker function to draw part of a trace into a stencil (parallelized)
+    // worker function to draw part of a trace (parallelized). pixOp is applied to the index of each pixel that is hit e.g. pixOpWriteId
     // template variants are separate at compile time for performance
-    template <bool hasX, bool hasMask>
-    static void drawDots(const job_t job) {
+    template <bool hasX, bool hasMask, typename tx_t, typename ty_t, typename pixOp_t>
+    static void drawDots(const job_t<tx_t, ty_t> job, const pixOp_t pixOp) {
         const int width = job.p.getScreenWidth();
         const int height = job.p.getScreenHeight();
 
         float plotX;  // if !hasX, use +1.0f increments instead of repeated int-to-float conversion
         if constexpr (!hasX)
-            plotX = job.ixStart + 1.0f;
+            plotX = 1.0f;
 
-        for (size_t ix = job.ixStart; ix < job.ixEnd; ++ix) {
-            if (!hasMask || (*(job.pMask))[ix] == job.maskVal) {
+        const size_t n = job.ixEnd - job.ixStart;
+        for (size_t i = 0; i < n; ++i) {
+            if (!hasMask || job.pMask[i] == job.maskVal) {
                 if constexpr (hasX)
-                    plotX = (*(job.pDataX))[ix];
+                    plotX = (float)job.pDataX[i];
                 int pixX = job.p.projX(plotX);
                 if ((pixX >= 0) && (pixX < width)) {
-                    float plotY = (*(job.pDataY))[ix];
+                    float plotY = (float)job.pDataY[i];
                     int pixY = job.p.projY(plotY);
                     if ((pixY >= 0) && (pixY < height))
-                        (*job.pStencil)[pixY * width + pixX] = 1;
+                        pixOp(pixY * width + pixX, job.ixStart + i);
                 }  // if x in range
             }      // if mask enables point
 
             if constexpr (!hasX)
                 plotX += 1.0f;
-        }  // for ix
+        }  // for i
+    }
+
+    // draws a line between two points in screen coordinates (see proj::projXf), clipped to the screen
+    template <typename pixOp_t>
+    static void drawSegment(float x0, float y0, float x1, float y1, int width, int height, size_t ixPt, const pixOp_t& pixOp) {
+        // === clip (Liang-Barsky) ===
+        const float dx = x1 - x0;
+        const float dy = y1 - y0;
+        float t0 = 0.0f;
+        float t1 = 1.0f;
+        const float p[4] = {-dx, dx, -dy, dy};
+        const float q[4] = {x0, width - x0, y0, height - y0};
+        for (int ix = 0; ix < 4; ++ix) {
+            if (p[ix] == 0.0f) {
+                if (q[ix] < 0.0f)
+                    return;  // parallel, outside
+                continue;
+            }
+            const float t = q[ix] / p[ix];
+            if (p[ix] < 0.0f)
+                t0 = std::max(t0, t);
+            else
+                t1 = std::min(t1, t);
+        }
+        if (!(t0 <= t1))
+            return;  // outside (or NaN)
+
+        // === integer endpoints (the clipped segment may end exactly on the far edge) ===
+        int pixX0 = toPix(x0 + t0 * dx, width);
+        int pixY0 = toPix(y0 + t0 * dy, height);
+        const int pixX1 = toPix(x0 + t1 * dx, width);
+        const int pixY1 = toPix(y0 + t1 * dy, height);
+
+        // === Bresenham ===
+        const int adx = std::abs(pixX1 - pixX0);
+        const int ady = -std::abs(pixY1 - pixY0);
+        const int sx = pixX0 < pixX1 ? 1 : -1;
+        const int sy = pixY0 < pixY1 ? 1 : -1;
+        int err = adx + ady;
+        while (true) {
+            pixOp((size_t)pixY0 * width + pixX0, ixPt);
+            if ((pixX0 == pixX1) && (pixY0 == pixY1))
+                return;
+            const int e2 = 2 * err;
+            if (e2 >= ady) {
+                err += ady;
+                pixX0 += sx;
+            }
+            if (e2 <= adx) {
+                err += adx;
+                pixY0 += sy;
+            }
+        }
+    }
+
+    // pixel index 0..n-1 of screen coordinate v, clamped (NaN: 0)
+    static inline int toPix(float v, int n) {
+        return (v >= 0.0f) ? (int)std::min(std::floor(v), (float)(n - 1)) : 0;
+    }
+
+    // index 0..n of v, clamped
+    static inline size_t toIndex(double v, size_t n, size_t ifNaN) {
+        if (std::isnan(v))
+            return ifNaN;
+        return (v <= 0.0) ? 0 : (v >= (double)n) ? n : (size_t)v;
+    }
+
+    // worker function to draw part of a trace as connected lines (parallelized): segments between consecutive points job.ixStart..job.ixEnd-1.
+    // A point that is masked out (or not finite) breaks the line.
+    // Consecutive points in the same pixel column collapse into one vertical span (first, min, max, last), so dense data needs one segment per column.
+    template <bool hasX, bool hasMask, typename tx_t, typename ty_t, typename pixOp_t>
+    static void drawLines(const job_t<tx_t, ty_t> job, const pixOp_t pixOp) {
+        const int width = job.p.getScreenWidth();
+        const int height = job.p.getScreenHeight();
+
+        bool havePrev = false;
+        float prevX = 0;
+        float prevY = 0;
+        int runCol = 0;
+        float runMin = 0;
+        float runMax = 0;
+        size_t runIxPt = 0;
+        auto flushRun = [&]() {
+            if (!havePrev || (runCol < 0) || (runCol >= width) || (runMax < 0.0f) || (runMin >= height))
+                return;
+            const int rowEnd = toPix(runMax, height);
+            for (int row = toPix(runMin, height); row <= rowEnd; ++row)
+                pixOp((size_t)row * width + runCol, runIxPt);
+        };
+
+        const size_t n = job.ixEnd - job.ixStart;
+        for (size_t i = 0; i < n; ++i) {
+            const size_t ix = job.ixStart + i;
+            const float x = job.p.projXf(hasX ? (float)job.pDataX[i] : (float)(i + 1));
+            const float y = job.p.projYf((float)job.pDataY[i]);
+            if ((hasMask && (job.pMask[i] != job.maskVal)) || !std::isfinite(x) || !std::isfinite(y)) {
+                flushRun();
+                havePrev = false;
+                continue;
+            }
+
+            // (off-screen columns collapse into -1 and width: a segment between them can't be visible)
+            const int col = (x < 0.0f) ? -1 : (x >= (float)width) ? width : (int)x;
+            if (havePrev && (col == runCol)) {
+                // === same column: extend vertical span ===
+                runMin = std::min(runMin, y);
+                runMax = std::max(runMax, y);
+                runIxPt = ix;
+            } else {
+                flushRun();
+                if (havePrev)
+                    drawSegment(prevX, prevY, x, y, width, height, ix, pixOp);
+                runCol = col;
+                runMin = runMax = y;
+                runIxPt = ix;
+            }
+            prevX = x;
+            prevY = y;
+            havePrev = true;
+        }
+        flushRun();
+    }
+
+    // as drawDots, using pre-scaled coordinates with the fixed point pan offset dx, dy
+    template <bool hasMask, typename pixOp_t>
+    static void drawDotsPixCoords(const job_t<float, float> job, const pixCoords_cl& pc, int64_t dx, int64_t dy, const pixOp_t pixOp) {
+        const int64_t width = job.p.getScreenWidth();
+        const int64_t height = job.p.getScreenHeight();
+        const int32_t* pX = pc.x.data();
+        const int32_t* pY = pc.y.data();
+        for (size_t ix = job.ixStart; ix < job.ixEnd; ++ix) {
+            if (!hasMask || job.pMask[ix - job.ixStart] == job.maskVal) {
+                const int64_t pixX = (pX[ix] + dx) >> pixCoords_cl::fracBits;
+                if ((pixX >= 0) && (pixX < width)) {
+                    const int64_t pixY = (pY[ix] + dy) >> pixCoords_cl::fracBits;
+                    if ((pixY >= 0) && (pixY < height))
+                        pixOp(pixY * width + pixX, ix);
+                }  // if x in range
+            }      // if mask enables point
+        }          // for ix
+    }
+
+    // as drawDots, for 16 bit codes of quantized data (see column_cl::quantized) with the chunk projection pQ (see proj::rebased).
+    // Fixed point with 32 fractional bits: integer multiply-add is cheaper than converting each code to float
+    template <bool hasMask, typename pixOp_t>
+    static void drawDotsCodes(const job_t<uint16_t, uint16_t> job, const proj<double>& pQ, const pixOp_t pixOp) {
+        const int64_t width = job.p.getScreenWidth();
+        const int64_t height = job.p.getScreenHeight();
+        const double one = 4294967296.0;
+        const int64_t mX = std::llround(pQ.getScaleX() * one);
+        const int64_t bX = std::llround(pQ.getOffsetX() * one);
+        const int64_t mY = std::llround(pQ.getScaleY() * one);
+        const int64_t bY = std::llround(pQ.getOffsetY() * one);
+        const size_t n = job.ixEnd - job.ixStart;
+        for (size_t i = 0; i < n; ++i) {
+            if (!hasMask || job.pMask[i] == job.maskVal) {
+                const int64_t pixX = (job.pDataX[i] * mX + bX) >> 32;
+                if ((uint64_t)pixX < (uint64_t)width) {
+                    const int64_t pixY = (job.pDataY[i] * mY + bY) >> 32;
+                    if ((uint64_t)pixY < (uint64_t)height)
+                        pixOp(pixY * width + pixX, job.ixStart + i);
+                }  // if x in range
+            }      // if mask enables point
+        }          // for i
+    }
+
+    // element types that kernels read natively. Others (64 bit) are converted to float per chunk
+    template <typename T>
+    static constexpr bool isKernelType() {
+        return std::is_same_v<T, float> || std::is_same_v<T, int8_t> || std::is_same_v<T, uint8_t> || std::is_same_v<T, int16_t> || std::is_same_v<T, uint16_t> || std::is_same_v<T, int32_t> || std::is_same_v<T, uint32_t>;
+    }
+
+    // max. step of quantized data (see column_cl::quantized) in pixels, for rendering from codes
+    static constexpr double maxCodeStepPix = 0.25;
+
+    // for one chunk of codes of a coordinate, given the screen position pix0 of code 0 and pixels per code step: returns false if no code can be on screen.
+    // Drops the codes (pCodes NULL, step 1) if they are too coarse for the view
+    static bool getCodesOnScreen(double pix0, double pixPerStep, int size, const uint16_t*& pCodes, double& step) {
+        const double pix1 = pix0 + 65535.0 * pixPerStep;
+        if ((std::max(pix0, pix1) < -1.0) || (std::min(pix0, pix1) > size + 1.0))
+            return false;  // (margin: projection truncates toward zero)
+        if (!(std::abs(pixPerStep) <= maxCodeStepPix)) {
+            pCodes = NULL;
+            step = 1.0;
+        }
+        return true;
+    }
+
+    // splits points ixBegin..ixEnd-1 into one job per chunk of column_cl, calling fn(ixJobBegin, ixOrigBegin, ixJobEnd).
+    // ixOrigBegin is the first point in the chunk (for its origin, see column_cl::getOrigin). Lines: jobs after the first start at the point before
+    template <typename fn_t>
+    void forEachColumnChunk(size_t ixBegin, size_t ixEnd, const fn_t& fn) const {
+        for (size_t ixOrigBegin = ixBegin; ixOrigBegin < ixEnd;) {
+            const size_t ixOrigEnd = std::min((ixOrigBegin / column_cl::chunkSize + 1) * column_cl::chunkSize, ixEnd);
+            const size_t ixJobBegin = ((mode == LINES) && (ixOrigBegin > ixBegin)) ? ixOrigBegin - 1 : ixOrigBegin;
+            fn(ixJobBegin, ixOrigBegin, ixOrigEnd);
+            ixOrigBegin = ixOrigEnd;
+        }
+    }
+
+    // projection for a job without X data, starting at point ixJobBegin (X = ixJobBegin + 1): relative in float, as float can't count points beyond 2^24
+    static proj<float> rebasedImplicitX(const proj<double>& pd, size_t ixJobBegin) {
+        return pd.rebased<float>((double)ixJobBegin, 0.0);
+    }
+
+    // renders a job (see drawChunk) with the kernel for the drawing mode and data
+    template <typename tx_t, typename ty_t, typename pixOp_t>
+    void drawJobChunk(const job_t<tx_t, ty_t> job, const pixOp_t pixOp) const {
+        // each of the following variants refers to a custom variant of the performance-critical "drawDots" function that has the conditions optimized out as constexpr
+        bool hasDataX = job.pDataX != NULL;
+        bool hasMask = job.pMask != NULL;
+
+        if (mode == LINES) {
+            if (!hasDataX && !hasMask)
+                drawLines</*hasDataX*/ false, /*hasMask*/ false>(job, pixOp);
+            else if (!hasDataX && hasMask)
+                drawLines</*hasDataX*/ false, /*hasMask*/ true>(job, pixOp);
+            else if (hasDataX && !hasMask)
+                drawLines</*hasDataX*/ true, /*hasMask*/ false>(job, pixOp);
+            else /*if (hasDataX && hasMask)*/
+                drawLines</*hasDataX*/ true, /*hasMask*/ true>(job, pixOp);
+            return;
+        }
+
+        if (!hasDataX && !hasMask)
+            drawDots</*hasDataX*/ false, /*hasMask*/ false>(job, pixOp);
+        else if (!hasDataX && hasMask)
+            drawDots</*hasDataX*/ false, /*hasMask*/ true>(job, pixOp);
+        else if (hasDataX && !hasMask)
+            drawDots</*hasDataX*/ true, /*hasMask*/ false>(job, pixOp);
+        else /*if (hasDataX && hasMask)*/
+            drawDots</*hasDataX*/ true, /*hasMask*/ true>(job, pixOp);
     }
 
    public:
-    drawJob(const vector<float>* pDataX,
-            const vector<float>* pDataY,
+    drawJob(const column_cl* pDataX,
+            const column_cl* pDataY,
             const vector<drawJob::annotation_cl> pAnnot,
             const marker_cl* marker,
             vector<float> vertLineX,
             vector<float> horLineY,
-            const vector<uint16_t>* pMask,
-            uint16_t maskVal)
+            const column_cl* pMask,
+            uint16_t maskVal,
+            drawMode_e mode = DOTS,
+            const colormap_cl* colormap = NULL,
+            const column_cl* pColorData = NULL,
+            float colorMin = std::numeric_limits<float>::quiet_NaN(),
+            float colorMax = std::numeric_limits<float>::quiet_NaN())
         : marker(marker),
           pDataX(pDataX),
           pDataY(pDataY),
@@ -99,218 +503,525 @@ class drawJob {
           vertLineX(vertLineX),
           horLineY(horLineY),
           pMask(pMask),
-          maskVal(maskVal) {}
-
-    // draws only horizontal and vertical lines to screen without use of a stencil
-    void drawLinesDirectly(const proj<double> pScreen) {
-        fl_color(marker->rgba & 0xFF, (marker->rgba >> 8) & 0xFF, (marker->rgba >> 16) & 0xFF);
-
-        // === vertical lines ===
-        for (float x : vertLineX) {
-            int pixX = pScreen.projX(x);
-            for (int dx = -marker->dxMinus; dx <= marker->dxPlus; ++dx) {
-                fl_begin_line();
-                fl_vertex(pixX + dx, pScreen.getScreenY0());
-                fl_vertex(pixX + dx, pScreen.getScreenY1());
-                fl_end_line();
-            }
+          maskVal(maskVal),
+          mode(mode),
+          colormap(colormap),
+          pColorData(pColorData),
+          colorMin(colorMin),
+          colorMax(colorMax),
+          autoColorRange(std::isnan(colorMin) || std::isnan(colorMax)) {
+        if ((mode == LINES) && pDataX && pDataY)
+            xSorted = isSorted(*pDataX, 0);
+        if (((mode == DENSITY) || (mode == COLORDATA)) && !colormap)
+            throw std::runtime_error("trace with per-pixel color requires a colormap");
+        if (mode == COLORDATA) {
+            if (!pDataY || !pColorData)
+                throw std::runtime_error("colorData requires dataY and colorData");
+            if (!pColorData->getNative<float>())
+                throw std::runtime_error("colorData must be of type float");
+            if (pColorData->size() != pDataY->size())
+                throw std::runtime_error("dataY and colorData differ in length");
+            if (pDataY->size() > std::numeric_limits<uint32_t>::max() - 2)
+                throw std::runtime_error("colorData: too many points");
+            // === autoscale color range (if not given) ===
+            if (autoColorRange)
+                updateColorRange(0);
         }
+    }
 
-        // === horizontal lines ===
-        for (float y : horLineY) {
-            int pixY = pScreen.projY(y);
-            for (int dy = -marker->dyMinus; dy <= marker->dyPlus; ++dy) {
-                fl_begin_line();
-                fl_vertex(pScreen.getScreenX0(), pixY + dy);
-                fl_vertex(pScreen.getScreenX1(), pixY + dy);
-                fl_end_line();
+    // prev with data that has grown: the first prev.getNPoints() points of the given data are those of prev (e.g. appended to a file).
+    // Derived data (sort order, color range, autoscale range) is extended from prev, for the new points only
+    drawJob(const drawJob& prev, const column_cl* pDataX, const column_cl* pDataY, const column_cl* pMask, const column_cl* pColorData, const column_cl* pCategory) : drawJob(prev) {
+        const size_t nPrev = prev.getNPoints();
+        if ((pDataX != NULL) != (prev.pDataX != NULL) || (pDataY != NULL) != (prev.pDataY != NULL) || (pMask != NULL) != (prev.pMask != NULL) || (pColorData != NULL) != (prev.pColorData != NULL) || (pCategory != NULL) != (prev.pCategory != NULL))
+            throw std::runtime_error("appended trace data differs in columns");
+        if (prev.pReordered)
+            throw std::runtime_error("reorder: data can't be appended");
+        if (pDataY && (pDataY->size() < nPrev))
+            throw std::runtime_error("appended trace data is shorter");
+        const size_t n = pDataY ? pDataY->size() : 0;
+        for (const column_cl* c : {pDataX, pMask, pColorData, pCategory})
+            if (c && (c->size() != n))
+                throw std::runtime_error("appended trace data differs in length");
+        this->pDataX = pDataX;
+        this->pDataY = pDataY;
+        this->pMask = pMask;
+        this->pColorData = pColorData;
+        this->pCategory = pCategory;
+        pPixCoords = NULL;
+        if (xSorted && (nPrev > 0))
+            xSorted = isSorted(*pDataX, nPrev - 1);
+        if ((mode == COLORDATA) && autoColorRange)
+            updateColorRange(nPrev);
+    }
+
+    // switches to CATEGORICAL mode: points are drawn by the marker of their category in pCategory. Points of a category missing in palette are not drawn.
+    // palette lists (category value, marker) by priority: later entries are drawn on top.
+    void setCategorical(const column_cl* pCategory, const vector<std::pair<uint16_t, const marker_cl*>>& palette) {
+        if (mode != DOTS)
+            throw std::runtime_error("categorical trace can't use another drawing mode");
+        if (!pDataY || !pCategory)
+            throw std::runtime_error("categorical trace requires dataY and category data");
+        if (pCategory->size() != pDataY->size())
+            throw std::runtime_error("dataY and category data differ in length");
+        if (!pCategory->getNative<uint16_t>())
+            throw std::runtime_error("category data must be of type uint16");
+        if (palette.size() > maxNCategories)
+            throw std::runtime_error("categorical trace: too many categories");
+        mode = CATEGORICAL;
+        this->pCategory = pCategory;
+        categoryBitByValue.assign(65536, 0);
+        categoryMarkers.assign({marker});  // lines
+        for (const auto& [value, m] : palette) {
+            if (categoryBitByValue[value])
+                throw std::runtime_error("categorical trace: duplicate category " + std::to_string(value));
+            categoryBitByValue[value] = (uint64_t)1 << categoryMarkers.size();
+            categoryMarkers.push_back(m);
+        }
+    }
+
+    // renders from data that is reordered for locality (see mortonOrder_cl, lifetime must exceed drawJob), instead of pDataX, pDataY, pMask, pCategory.
+    // The original data is still used for point lookup, annotations and autoscale. Point indices are original indices.
+    void setReordered(const mortonOrder_cl* pReordered) {
+        if (mode == LINES)
+            throw std::runtime_error("reorder: not supported for lines");
+        if (pReordered && (pReordered->y.size() != (pDataY ? pDataY->size() : 0)))
+            throw std::runtime_error("reorder: inconsistent trace data size");
+        if (pReordered && ((pReordered->mask.size() > 0) != (pMask != NULL) || (pReordered->category.size() > 0) != (pCategory != NULL)))
+            throw std::runtime_error("reorder: mask / category data mismatch");
+        this->pReordered = pReordered;
+    }
+
+    // computes pre-scaled coordinates for the zoom level of p (see pixCoords_cl). Returns an invalid result if cancelled. Thread safe.
+    pixCoords_cl buildPixCoords(const proj<double>& p, const std::atomic<bool>& cancel) const {
+        pixCoords_cl r;
+        if (!pDataY)
+            return r;
+        r.p = p;
+        if (!extendPixCoords(r, cancel))
+            return pixCoords_cl();
+        r.valid = true;
+        return r;
+    }
+
+    // adds the coordinates of points that are not in r yet (data has grown), for the zoom level r.p. Returns false if cancelled
+    bool extendPixCoords(pixCoords_cl& r, const std::atomic<bool>& cancel) const {
+        const size_t n = pDataY ? pDataY->size() : 0;
+        const size_t nDone = r.x.size();
+        if (nDone >= n)
+            return true;
+        const proj<double>& p = r.p;
+        // (the same transformation as the kernels, see drawChunk)
+        const proj<float> pf(p);
+        r.x.resize(n);
+        r.y.resize(n);
+        vector<float> bufX;
+        vector<float> bufY;
+        // (in chunks of rebased data, the first one may be partial)
+        for (size_t ixBegin = nDone, ixEnd; ixBegin < n; ixBegin = ixEnd) {
+            if (cancel)
+                return false;
+            ixEnd = std::min((ixBegin / column_cl::chunkSize + 1) * column_cl::chunkSize, n);
+            // === rebased or quantized data: relative to the origin of the chunk. Implicit X: relative to the start of the chunk ===
+            const bool implicitX = !pReordered && !pDataX;
+            const bool rebasedX = implicitX || (!pReordered && pDataX && pDataX->hasOrigins());
+            const bool rebasedY = !pReordered && pDataY->hasOrigins();
+            const size_t ixChunkBegin = ixBegin / column_cl::chunkSize * column_cl::chunkSize;
+            const double oX = implicitX ? (double)ixChunkBegin : rebasedX ? pDataX->getOrigin(ixBegin) : 0.0;
+            const double oY = rebasedY ? pDataY->getOrigin(ixBegin) : 0.0;
+            // (float arithmetic as in the kernels: at the view of r.p, each point falls on the same pixel)
+            const proj<float> pk = (rebasedX || rebasedY) ? p.rebased<float>(oX, oY) : pf;
+            const float mX = pk.getScaleX();
+            const float bX = pk.getOffsetX();
+            const float mY = pk.getScaleY();
+            const float bY = pk.getOffsetY();
+            const float* pX = pReordered ? pReordered->x.data() + ixBegin : pDataX ? pDataX->getChunkRelative(ixBegin, ixEnd, oX, bufX) : NULL;
+            const float* pY = pReordered ? pReordered->y.data() + ixBegin : pDataY->getChunkRelative(ixBegin, ixEnd, oY, bufY);
+            for (size_t ix = ixBegin; ix < ixEnd; ++ix) {
+                const float x = pX ? pX[ix - ixBegin] : (float)(ix - ixChunkBegin + 1);
+                r.x[ix] = pixCoords_cl::toFixed(x * mX + bX);
+                r.y[ix] = pixCoords_cl::toFixed(pY[ix - ixBegin] * mY + bY);
             }
         }
+        return true;
+    }
+
+    // pre-scaled coordinates to use for rendering when applicable (set by allDrawJobs_cl, NULL: none). Not used in LINES mode
+    void usePixCoords(const pixCoords_cl* pPixCoords) {
+        this->pPixCoords = pPixCoords;
+    }
+
+    size_t getNPoints() const {
+        return pDataY ? pDataY->size() : 0;
     }
 
-    bool hasPoints() {
+    // original index by position in reordered data (NULL: not reordered)
+    const vector<uint32_t>* getPerm() const {
+        return pReordered ? &pReordered->perm : NULL;
+    }
+
+    // marker by category bit (see pixOpSetCategoryBit)
+    const vector<const marker_cl*>& getCategoryMarkers() const {
+        return categoryMarkers;
+    }
+
+    // 1 + index of the highest set bit (0: none)
+    static inline uint8_t topCategory(uint64_t bits) {
+        uint8_t r = 0;
+        while (bits) {
+            bits >>= 1;
+            ++r;
+        }
+        return r;
+    }
+
+    bool hasPoints() const {
         return pDataY != NULL;
     }
 
-    void drawToStencil(const proj<float> p, vector<stencil_t>& stencil) {
-        // === vertical lines ===
+    // memory held by the X and Y data in bytes
+    size_t getDataBytes() const {
+        return (pDataX ? pDataX->getBytes() : 0) + (pDataY ? pDataY->getBytes() : 0);
+    }
+
+    drawMode_e getMode() const {
+        return mode;
+    }
+
+    // true if the color of the trace varies per pixel (rendered by allDrawJobs_cl into an RGBA layer instead of using the marker color)
+    bool hasPerPixelColor() const {
+        return (mode == DENSITY) || (mode == COLORDATA) || (mode == CATEGORICAL);
+    }
+
+    // the marker that is used for convolution of the layer ID buffer
+    // (single pixel for per-pixel color. In COLORDATA and CATEGORICAL mode, markers are already applied to the RGBA layer)
+    const marker_cl* getShapeMarker() const {
+        static const marker_cl singlePixel("X", 0);
+        return hasPerPixelColor() ? &singlePixel : marker;
+    }
+
+    const colormap_cl* getColormap() const {
+        return colormap;
+    }
+
+    // number of chunks for parallel rendering via drawChunk()
+    size_t getNChunks() const {
+        if (!pDataY)
+            return 1;  // lines only
+        return std::max((pDataY->size() + chunkSize - 1) / chunkSize, (size_t)1);
+    }
+
+    // renders one chunk of points, applying pixOp to each pixel that is hit (see drawDots). Lines are drawn with the first chunk.
+    // Note: Different chunks may be rendered in parallel but need separate output (e.g. ID buffers), unless writes are identical.
+    // The kernels project in float (p converted). Rebased data (see column_cl::rebased) is projected relative to the origin of each of its chunks.
+    template <typename pixOp_t>
+    void drawChunk(size_t ixChunk, const proj<double>& pd, const pixOp_t pixOp) const {
+        const proj<float> p(pd);
         const int width = p.getScreenWidth();
         const int height = p.getScreenHeight();
-        for (float x : vertLineX) {
-            int pixX = p.projX(x);
-            if ((pixX >= 0) && (pixX < width))
-                for (int pixY = 0; pixY < height; ++pixY)
-                    stencil[pixY * width + pixX] = 1;
-        }
+        if (ixChunk == 0) {
+            // === vertical lines ===
+            for (float x : vertLineX) {
+                int pixX = p.projX(x);
+                if ((pixX >= 0) && (pixX < width))
+                    for (int pixY = 0; pixY < height; ++pixY)
+                        pixOp(pixY * width + pixX, ixPtLine);
+            }
 
-        // === horizontal lines ===
-        for (float y : horLineY) {
-            int pixY = p.projY(y);
-            if ((pixY >= 0) && (pixY < height))
-                for (int pixX = 0; pixX < width; ++pixX)
-                    stencil[pixY * width + pixX] = 1;
+            // === horizontal lines ===
+            for (float y : horLineY) {
+                int pixY = p.projY(y);
+                if ((pixY >= 0) && (pixY < height))
+                    for (int pixX = 0; pixX < width; ++pixX)
+                        pixOp(pixY * width + pixX, ixPtLine);
+            }
         }
 
         // === traces ===
         if (!pDataY)
             return;
         size_t nData = pDataY->size();
-        const size_t chunk = 65536 * 16;
-        vector<std::future<void>> futs;
-        for (size_t chunkIxStart = 0; chunkIxStart < nData; chunkIxStart += chunk) {
-            size_t chunkIxEnd = std::min(chunkIxStart + chunk, nData);
-            job_t job(chunkIxStart, chunkIxEnd, pDataX, pDataY, p, pMask, maskVal, &stencil);
+        size_t chunkIxStart = ixChunk * chunkSize;
+        if (chunkIxStart >= nData)
+            return;
+        size_t chunkIxEnd = std::min(chunkIxStart + chunkSize, nData);
 
-            // === sanity check ===
-            if (pDataX && pDataY && (pDataX->size() != pDataY->size()))
-                throw std::runtime_error("dataX / dataY vectors differ in length");
+        if (mode == LINES) {
+            // === limit to points in the visible X range (plus one on each side for the segment leaving the screen) ===
+            size_t ixVisBegin = 0;
+            size_t ixVisEnd = nData;
+            // (pixel columns at the edges extend half a pixel beyond the data range. Use some margin)
+            const double margin = 2.0 * std::abs(pd.getDataX1() - pd.getDataX0()) / std::max(width, 1);
+            const double x0 = std::min(pd.getDataX0(), pd.getDataX1()) - margin;
+            const double x1 = std::max(pd.getDataX0(), pd.getDataX1()) + margin;
+            if (!pDataX) {
+                ixVisBegin = toIndex(std::floor(x0) - 2.0, nData, /*NaN*/ 0);
+                ixVisEnd = toIndex(std::ceil(x1) + 1.0, nData, /*NaN*/ nData);
+            } else if (xSorted) {
+                ixVisBegin = lowerBound(*pDataX, x0, /*upper*/ false);
+                ixVisBegin = ixVisBegin > 0 ? ixVisBegin - 1 : 0;
+                ixVisEnd = lowerBound(*pDataX, x1, /*upper*/ true);
+                ixVisEnd = std::min(ixVisEnd + 1, nData);
+            }
+            // (drawLines() starts at the point before chunkIxStart)
+            if (ixVisBegin > 0)
+                chunkIxStart = std::max(chunkIxStart, ixVisBegin + 1);
+            chunkIxEnd = std::min(chunkIxEnd, ixVisEnd);
+            if (chunkIxStart >= chunkIxEnd)
+                return;
+        }
 
-            if (pMask && pDataY && (pMask->size() != pDataY->size()))
-                throw std::runtime_error("dataY and mask differ in length");
+        // === sanity check ===
+        if (pDataX && (pDataX->size() != nData))
+            throw std::runtime_error("dataX / dataY vectors differ in length");
 
-            // each of the following variants refers to a custom variant of the performance-critical "drawDots" function that has the conditions optimized out as constexpr
-            bool hasDataX = pDataX != NULL;
-            bool hasMask = pMask != NULL;
+        if (pMask && (pMask->size() != nData))
+            throw std::runtime_error("dataY and mask differ in length");
 
-            if (!hasDataX && !hasMask)
-                futs.push_back(std::async(drawDots</*hasDataX*/ false, /*hasMask*/ false>, /*pass by value*/ job));
-            else if (!hasDataX && hasMask)
-                futs.push_back(std::async(drawDots</*hasDataX*/ false, /*hasMask*/ true>, /*pass by value*/ job));
-            else if (hasDataX && !hasMask)
-                futs.push_back(std::async(drawDots</*hasDataX*/ true, /*hasMask*/ false>, /*pass by value*/ job));
-            else /*if (hasDataX && hasMask)*/
-                futs.push_back(std::async(drawDots</*hasDataX*/ true, /*hasMask*/ true>, /*pass by value*/ job));
+        // === mask of the chunk ===
+        // (drawLines() starts at the point before chunkIxStart)
+        const size_t ixBegin = ((mode == LINES) && (chunkIxStart > 0)) ? chunkIxStart - 1 : chunkIxStart;
+        vector<uint16_t> bufM;
+        const uint16_t* pM = NULL;
+        if (pMask)
+            pM = pReordered ? pReordered->mask.data() + ixBegin : pMask->getChunk<uint16_t>(ixBegin, chunkIxEnd, bufM);
+
+        // === pre-scaled coordinates, if the view is a pan of theirs ===
+        int64_t dx, dy;
+        if (pPixCoords && (mode != LINES) && (pPixCoords->x.size() == nData) && pPixCoords->getOffset(pd, dx, dy)) {
+            const job_t<float, float> job(ixBegin, chunkIxEnd, NULL, NULL, p, pM, maskVal);
+            if (pM)
+                drawDotsPixCoords</*hasMask*/ true>(job, *pPixCoords, dx, dy, pixOp);
+            else
+                drawDotsPixCoords</*hasMask*/ false>(job, *pPixCoords, dx, dy, pixOp);
+            return;
+        }
+
+        // === X / Y data of the chunk: reordered, if any ===
+        if (pReordered) {
+            drawJobChunk(job_t<float, float>(ixBegin, chunkIxEnd, pReordered->x.data() + ixBegin, pReordered->y.data() + ixBegin, p, pM, maskVal), pixOp);
+            return;
+        }
+
+        // === quantized data: one job per chunk of the codes, skipped if their range is off screen. Codes where precise enough for the view, otherwise the exact data ===
+        if ((mode != LINES) && (pDataY->isQuantized() || (pDataX && pDataX->isQuantized()))) {
+            vector<float> bufX;
+            vector<float> bufY;
+            for (size_t ixQBegin = ixBegin; ixQBegin < chunkIxEnd; ixQBegin += column_cl::chunkSize) {
+                const size_t ixQEnd = std::min(ixQBegin + column_cl::chunkSize, chunkIxEnd);
+                const size_t ixQChunk = ixQBegin / column_cl::chunkSize;
+                const uint16_t* pXCodes = NULL;
+                const uint16_t* pYCodes = NULL;
+                double oX = pDataX ? pDataX->getOrigin(ixQBegin) : (double)ixQBegin;
+                double oY = pDataY->getOrigin(ixQBegin);
+                double stepX = 1.0;
+                double stepY = 1.0;
+                if (pDataX && pDataX->getCodes(ixQChunk, pXCodes, oX, stepX) && !getCodesOnScreen(pd.rebased<double>(oX, 0, stepX, 1).projXf(0), stepX * pd.getScaleX(), width, pXCodes, stepX))
+                    continue;
+                if (pDataY->getCodes(ixQChunk, pYCodes, oY, stepY) && !getCodesOnScreen(pd.rebased<double>(0, oY, 1, stepY).projYf(0), stepY * pd.getScaleY(), height, pYCodes, stepY))
+                    continue;
+                const float* pX = (pDataX && !pXCodes) ? pDataX->getChunkRelative(ixQBegin, ixQEnd, oX, bufX) : NULL;
+                const float* pY = pYCodes ? NULL : pDataY->getChunkRelative(ixQBegin, ixQEnd, oY, bufY);
+                const proj<float> pQ = pd.rebased<float>(oX, oY, stepX, stepY);
+                const uint16_t* pMQ = pM ? pM + (ixQBegin - ixBegin) : NULL;
+                if (pXCodes && pYCodes) {
+                    const job_t<uint16_t, uint16_t> job(ixQBegin, ixQEnd, pXCodes, pYCodes, pQ, pMQ, maskVal);
+                    if (pMQ)
+                        drawDotsCodes</*hasMask*/ true>(job, pd.rebased<double>(oX, oY, stepX, stepY), pixOp);
+                    else
+                        drawDotsCodes</*hasMask*/ false>(job, pd.rebased<double>(oX, oY, stepX, stepY), pixOp);
+                } else if (pXCodes)
+                    drawJobChunk(job_t<uint16_t, float>(ixQBegin, ixQEnd, pXCodes, pY, pQ, pMQ, maskVal), pixOp);
+                else if (pYCodes)
+                    drawJobChunk(job_t<float, uint16_t>(ixQBegin, ixQEnd, pX, pYCodes, pQ, pMQ, maskVal), pixOp);
+                else
+                    drawJobChunk(job_t<float, float>(ixQBegin, ixQEnd, pX, pY, pQ, pMQ, maskVal), pixOp);
+            }
+            return;
         }
-        for (std::future<void>& f : futs)
-            f.get();
+
+        // === rebased data (also quantized data for lines): float offsets, one job per origin ===
+        if (pDataY->hasOrigins() || (pDataX && pDataX->hasOrigins())) {
+            vector<float> bufX;
+            vector<float> bufY;
+            // (lines: from the point before, converted to this origin)
+            forEachColumnChunk(ixBegin, chunkIxEnd, [&](size_t ixJobBegin, size_t ixOrigBegin, size_t ixOrigEnd) {
+                const double oX = pDataX ? pDataX->getOrigin(ixOrigBegin) : (double)ixJobBegin;
+                const double oY = pDataY->getOrigin(ixOrigBegin);
+                const float* pX = pDataX ? pDataX->getChunkRelative(ixJobBegin, ixOrigEnd, oX, bufX) : NULL;
+                const float* pY = pDataY->getChunkRelative(ixJobBegin, ixOrigEnd, oY, bufY);
+                const uint16_t* pMJob = pM ? pM + (ixJobBegin - ixBegin) : NULL;
+                drawJobChunk(job_t<float, float>(ixJobBegin, ixOrigEnd, pX, pY, pd.rebased<float>(oX, oY), pMJob, maskVal), pixOp);
+            });
+            return;
+        }
+
+        // === native type, without conversion (X: if the same type as Y or float) ===
+        pDataY->visit([&](const auto* pYNative) {
+            typedef std::remove_cv_t<std::remove_pointer_t<decltype(pYNative)>> ty_t;
+            const ty_t* pY = pYNative + ixBegin;
+            if constexpr (isKernelType<ty_t>()) {
+                if (!pDataX)
+                    forEachColumnChunk(ixBegin, chunkIxEnd, [&](size_t ixJobBegin, size_t /*ixOrigBegin*/, size_t ixJobEnd) {
+                        drawJobChunk(job_t<float, ty_t>(ixJobBegin, ixJobEnd, NULL, pY + (ixJobBegin - ixBegin), rebasedImplicitX(pd, ixJobBegin), pM ? pM + (ixJobBegin - ixBegin) : NULL, maskVal), pixOp);
+                    });
+                else if (const ty_t* pXNative = pDataX->getNative<ty_t>())
+                    drawJobChunk(job_t<ty_t, ty_t>(ixBegin, chunkIxEnd, pXNative + ixBegin, pY, p, pM, maskVal), pixOp);
+                else {
+                    vector<float> bufX;
+                    drawJobChunk(job_t<float, ty_t>(ixBegin, chunkIxEnd, pDataX->getChunk<float>(ixBegin, chunkIxEnd, bufX), pY, p, pM, maskVal), pixOp);
+                }
+            } else {
+                // === other types: convert to float ===
+                vector<float> bufX;
+                vector<float> bufY;
+                const float* pYFloat = pDataY->getChunk<float>(ixBegin, chunkIxEnd, bufY);
+                if (!pDataX)
+                    forEachColumnChunk(ixBegin, chunkIxEnd, [&](size_t ixJobBegin, size_t /*ixOrigBegin*/, size_t ixJobEnd) {
+                        drawJobChunk(job_t<float, float>(ixJobBegin, ixJobEnd, NULL, pYFloat + (ixJobBegin - ixBegin), rebasedImplicitX(pd, ixJobBegin), pM ? pM + (ixJobBegin - ixBegin) : NULL, maskVal), pixOp);
+                    });
+                else
+                    drawJobChunk(job_t<float, float>(ixBegin, chunkIxEnd, pDataX->getChunk<float>(ixBegin, chunkIxEnd, bufX), pYFloat, p, pM, maskVal), pixOp);
+            }
+        });
     }
 
-    static vector<stencil_t>
-    convolveStencil(const vector<stencil_t>& stencil, int width, int height, const marker_cl* marker) {
-        vector<stencil_t> r(stencil);  // center pixel
-                                       //        return r;
+    // marker convolution on a layer ID buffer, for rows rowBegin..rowEnd-1 of dest: the highest ID covering a pixel wins.
+    // src must hold only IDs of traces that use a marker with the shape of 'marker'. Also used on point index buffers (uint32_t).
+    template <typename id_t>
+    static void dilateIdBuf(const vector<id_t>& src, int width, int height, const marker_cl* marker, vector<id_t>& dest, int rowBegin, int rowEnd) {
+        assert((int)src.size() == width * height);
+        assert((int)dest.size() == width * height);
         int markerSeqPos = 0;
         for (int dx = -marker->dxMinus; dx <= marker->dxPlus; ++dx) {
             for (int dy = -marker->dyMinus; dy <= marker->dyPlus; ++dy, ++markerSeqPos) {
-                if ((dx == 0) && (dy == 0))
-                    continue;  // center pixel is set by return value constructor
-                if (marker->seq[markerSeqPos]) {
-                    int ixSrc = 0;
-                    int ixDest = 0;
-                    int absDx = std::abs(dx);
-                    int absDy = std::abs(dy);
-                    if (dx < 0)
-                        ixSrc += absDx;
-                    if (dx > 0)
-                        ixDest += absDx;
-                    if (dy < 0)
-                        ixSrc += absDy * width;
-                    if (dy > 0)
-                        ixDest += absDy * width;
-                    for (int ixRow = height - absDy; ixRow != 0; --ixRow) {
-                        for (int ixCol = width - absDx; ixCol != 0; --ixCol) {
-                            assert(ixSrc >= 0);
-                            assert(ixDest >= 0);
-                            assert(ixSrc < (int)r.size());
-                            assert(ixDest < (int)r.size());
-                            r[ixDest] = r[ixDest] | stencil[ixSrc];
-                            ++ixDest;
-                            ++ixSrc;
-                        }  // for column
-                        ixDest += absDx;
-                        ixSrc += absDx;
-                    }  // for row
-                }      // if marker pixel enabled
-            }          // for marker column
-        }              // for marker row
-        return r;
+                if (!marker->seq[markerSeqPos])
+                    continue;
+                // dest pixel (x, y) gets src pixel (x-dx, y-dy)
+                const int colBegin = std::max(0, dx);
+                const int colEnd = std::min(width, width + dx);
+                const int rBegin = std::max(rowBegin, dy);
+                const int rEnd = std::min(rowEnd, height + dy);
+                for (int row = rBegin; row < rEnd; ++row) {
+                    id_t* pDest = &dest[row * width];
+                    const id_t* pSrc = &src[(row - dy) * width - dx];
+                    for (int col = colBegin; col < colEnd; ++col)
+                        pDest[col] = std::max(pDest[col], pSrc[col]);
+                }  // for row
+            }      // for marker column
+        }          // for marker row
     }
 
-    static void drawStencil2rgba(const vector<stencil_t>& stencil, int width, int height, const marker_cl* marker, vector<uint32_t>& rgba) {
-        assert((int)stencil.size() == width * height);
-        assert((int)rgba.size() == width * height);
-        uint32_t markerRgba = marker->rgba;
+    // converts pixels rowBegin..rowEnd-1 of the layer ID buffer to RGBA, using the color of each trace (index is ID)
+    // or, if non-NULL, the trace's RGBA layer (per-pixel color e.g. density)
+    static void drawIdBuf2rgba(const vector<layerId_t>& idBuf, int width, const vector<uint32_t>& rgbaById, const vector<const vector<uint32_t>*>& rgbaLayerById, vector<uint32_t>& rgba, int rowBegin, int rowEnd) {
+        assert(idBuf.size() == rgba.size());
+        const size_t ixMax = (size_t)rowEnd * width;
+        for (size_t ix = (size_t)rowBegin * width; ix < ixMax; ++ix) {
+            layerId_t id = idBuf[ix];
+            const vector<uint32_t>* pLayer = rgbaLayerById[id];
+            rgba[ix] = pLayer ? (*pLayer)[ix] : rgbaById[id];
+        }
+    }
 
-        // === convert to RGBA image ===
-        size_t ixMax = stencil.size();
-        for (size_t ix = 0; ix < ixMax; ++ix)
-            rgba[ix] = stencil[ix] ? markerRgba : 0;
+    // maps per-pixel hit counts to RGBA on a log scale (zero: transparent)
+    static void drawCounts2rgba(const vector<uint32_t>& counts, uint32_t maxCount, const colormap_cl* colormap, vector<uint32_t>& rgba, size_t ixBegin, size_t ixEnd) {
+        assert(counts.size() == rgba.size());
+        const colormap_cl::logScale_cl logScale(colormap, maxCount);
+        for (size_t ix = ixBegin; ix < ixEnd; ++ix)
+            rgba[ix] = logScale(counts[ix]);
+    }
+
+    // maps a point index buffer (see pixOpWritePointIndex) to RGBA via colorData (COLORDATA mode). Lines use the marker color.
+    void drawPointIndex2rgba(const vector<uint32_t>& ixBuf, vector<uint32_t>& rgba, size_t ixBegin, size_t ixEnd) const {
+        assert(mode == COLORDATA);
+        assert(ixBuf.size() == rgba.size());
+        const float scale = (colorMax > colorMin) ? 1.0f / (colorMax - colorMin) : 0.0f;
+        for (size_t ix = ixBegin; ix < ixEnd; ++ix) {
+            const uint32_t v = ixBuf[ix];
+            if (v < 2) {
+                rgba[ix] = v ? marker->rgba : 0;
+                continue;
+            }
+            const float c = pColorData->getNative<float>()[v - 2];
+            rgba[ix] = std::isnan(c) ? marker->rgba : colormap->rgba((c - colorMin) * scale);
+        }
     }
 
     //* render the RGBA image repeatedly, as defined by the marker sequence */
     static void
     drawRgba2screen(const vector<uint32_t>& rgba, int screenX, int screenY, int screenWidth, int screenHeight) {
         assert(screenWidth * screenHeight == (int)rgba.size());
-        Fl_RGB_Image im((const uchar*)&rgba[0], screenWidth, screenHeight, 4);
+        Fl_RGB_Image im((const uchar*)rgba.data(), screenWidth, screenHeight, 4);
         im.draw(screenX, screenY);
     }
 
     /** given limits are extended to include data */
-    void updateAutoscaleX(float& x0, float& x1) const {
+    void updateAutoscaleX(double& x0, double& x1) const {
         if (pDataY) {
             if (pDataX == NULL) {  // xdata exists only combined with Ydata (otherwise, the trade holds just lines)
-                x0 = std::min(x0, 1.0f);
-                x1 = std::max(x1, (float)(pDataY->size() + 1));
+                x0 = std::min(x0, 1.0);
+                x1 = std::max(x1, (double)(pDataY->size() + 1));
             } else {
-                for (float x : *pDataX) {
-                    if (!std::isinf(x) && !std::isnan(x)) {
-                        x0 = std::min(x0, x);
-                        x1 = std::max(x1, x);
-                    }
-                }
+                updateDataRange();
+                x0 = std::min(x0, rangeX0);
+                x1 = std::max(x1, rangeX1);
             }
         }
-        for (auto x : vertLineX) {
+        for (double x : vertLineX) {
             x0 = std::min(x0, x);
             x1 = std::max(x1, x);
         }
     }
 
     /** given limits are extended to include data */
-    void updateAutoscaleY(float& y0, float& y1) const {
+    void updateAutoscaleY(double& y0, double& y1) const {
         if (pDataY) {
-            for (float y : *pDataY) {
-                if (!std::isinf(y) && !std::isnan(y)) {
-                    y0 = std::min(y0, y);
-                    y1 = std::max(y1, y);
-                }
-            }
+            updateDataRange();
+            y0 = std::min(y0, rangeY0);
+            y1 = std::max(y1, rangeY1);
         }
-        for (auto y : horLineY) {
+        for (double y : horLineY) {
             y0 = std::min(y0, y);
             y1 = std::max(y1, y);
         }
     }
 
-    bool findClosestPoint(int xScreen, int yScreen, const proj<float>& p, size_t& ixPt, int& bestDist) const {
+    bool findClosestPoint(int xScreen, int yScreen, const proj<double>& p, size_t& ixPt, int& bestDist) const {
         bool r = false;
         if (bestDist == 0)
             return r;  // can't do any better
         if (pDataY) {
-            const size_t nPts = pDataY->size();
-            if (pDataX) {
-                for (size_t ix = 0; ix < nPts; ++ix) {
-                    float xData = (*pDataX)[ix];
-                    float yData = (*pDataY)[ix];
-                    if (xData < p.getDataX0() || (xData > p.getDataX1()) || (yData < p.getDataY0()) || (yData > p.getDataY1()))
-                        continue;
-                    int xDataP = p.projX(xData);
-                    int yDataP = p.projY(yData);
-                    int dist = (xDataP - xScreen) * (xDataP - xScreen) + (yDataP - yScreen) * (yDataP - yScreen);
-                    if (dist < bestDist) {
-                        ixPt = ix;
-                        bestDist = dist;
-                        r = true;
-                    }
+            // (per chunk, relative to the origin of rebased data. Quantized data: codes where precise enough, as for rendering)
+            vector<float> bufX;
+            vector<float> bufY;
+            const size_t n = pDataY->size();
+            for (size_t ixBegin = 0; ixBegin < n; ixBegin += column_cl::chunkSize) {
+                const size_t ixEnd = std::min(ixBegin + column_cl::chunkSize, n);
+                const uint16_t* pXCodes = NULL;
+                const uint16_t* pYCodes = NULL;
+                double oX = pDataX ? pDataX->getOrigin(ixBegin) : 0.0;
+                double oY = pDataY->getOrigin(ixBegin);
+                double stepX = 1.0;
+                double stepY = 1.0;
+                if (pDataX && pDataX->getCodes(ixBegin / column_cl::chunkSize, pXCodes, oX, stepX) && !(std::abs(stepX * p.getScaleX()) <= maxCodeStepPix)) {
+                    pXCodes = NULL;
+                    stepX = 1.0;
                 }
-            } else {
-                for (size_t ix = 0; ix < nPts; ++ix) {
-                    float xData = (float)(ix + 1);
-                    float yData = (*pDataY)[ix];
-                    if (xData < p.getDataX0() || (xData > p.getDataX1()) || (yData < p.getDataY0()) || (yData > p.getDataY1()))
+                if (pDataY->getCodes(ixBegin / column_cl::chunkSize, pYCodes, oY, stepY) && !(std::abs(stepY * p.getScaleY()) <= maxCodeStepPix)) {
+                    pYCodes = NULL;
+                    stepY = 1.0;
+                }
+                const proj<double> pRebased = p.rebased<double>(oX, oY, stepX, stepY);
+                const float* pX = (pDataX && !pXCodes) ? pDataX->getChunkRelative(ixBegin, ixEnd, oX, bufX) : NULL;
+                const float* pY = pYCodes ? NULL : pDataY->getChunkRelative(ixBegin, ixEnd, oY, bufY);
+                for (size_t ix = ixBegin; ix < ixEnd; ++ix) {
+                    double xData = pXCodes ? pXCodes[ix - ixBegin] : pX ? pX[ix - ixBegin] : (double)(ix + 1);
+                    double yData = pYCodes ? pYCodes[ix - ixBegin] : pY[ix - ixBegin];
+                    if (xData < pRebased.getDataX0() || (xData > pRebased.getDataX1()) || (yData < pRebased.getDataY0()) || (yData > pRebased.getDataY1()))
                         continue;
-                    int xDataP = p.projX(xData);
-                    int yDataP = p.projY(yData);
+                    int xDataP = pRebased.projX(xData);
+                    int yDataP = pRebased.projY(yData);
                     int dist = (xDataP - xScreen) * (xDataP - xScreen) + (yDataP - yScreen) * (yDataP - yScreen);
                     if (dist < bestDist) {
                         ixPt = ix;
@@ -323,12 +1034,18 @@ class drawJob {
         return r;
     }
 
-    void getPt(size_t ixPt, float& x, float& y) const {
+    void getPt(size_t ixPt, double& x, double& y) const {
         if (pDataX != NULL)
-            x = (*pDataX)[ixPt];
+            x = pDataX->at<double>(ixPt);
         else
             x = ixPt + 1;
-        y = (*pDataY)[ixPt];
+        y = pDataY->at<double>(ixPt);
+    }
+
+    // resolution of the values of getPt (see column_cl::getResolution)
+    void getPtResolution(size_t ixPt, double& resX, double& resY) const {
+        resX = (pDataX != NULL) ? pDataX->getResolution(ixPt) : 1.0;
+        resY = pDataY->getResolution(ixPt);
     }
 
     // returns all annotations for a given point
@@ -341,7 +1058,7 @@ class drawJob {
                 // === indirect lookup ===
                 if (ixPt >= a.mapping->size())
                     continue;  // indirect mapping table too short
-                ixLookup = (*a.mapping)[ixPt];
+                ixLookup = a.mapping->at<uint32_t>(ixPt);
             } else {
                 // === direct lookup ===
                 ixLookup = ixPt;
@@ -355,21 +1072,148 @@ class drawJob {
 
     const marker_cl* marker;
 
+    // number of points per chunk for parallel rendering
+    static const size_t chunkSize = 65536 * 16;
+
    protected:
     // X location of points (NULL: use 1, 2, ..., N)
-    const vector<float>* pDataX;
+    const column_cl* pDataX;
     // Y location of points (NULL: no data)
-    const vector<float>* pDataY;
+    const column_cl* pDataY;
     // Annotations, one per pDataY point (trace may have any number of independent annotations)
-    const vector<drawJob::annotation_cl> pAnnot;
+    vector<drawJob::annotation_cl> pAnnot;
     // vertical lines
     vector<float> vertLineX;
     // horizontal lines
     vector<float> horLineY;
     // mask value for each pDataY point (NULL: no mask). If set, only points with mask==maskVal are plotted.
-    const vector<uint16_t>* pMask;
+    const column_cl* pMask;
     // mask value (if pMask is non-NULL). If the latter, only points with mask==maskVal are plotted.
     uint16_t maskVal;
+    // rendering of points
+    drawMode_e mode;
+    // colormap for per-pixel colors (NULL: not used)
+    const colormap_cl* colormap;
+    // color value for each pDataY point (COLORDATA mode, type float)
+    const column_cl* pColorData;
+    // color value mapped to the first / last colormap entry
+    float colorMin;
+    float colorMax;
+    // colorMin, colorMax follow the data (not given)
+    bool autoColorRange;
+    // autoColorRange: some color value was valid (else, the range is 0..0)
+    bool hasColorValues = false;
+    // category of each pDataY point (CATEGORICAL mode, type uint16)
+    const column_cl* pCategory = NULL;
+    // category bit by value of pCategory (0: not drawn)
+    vector<uint64_t> categoryBitByValue;
+    // marker by category bit
+    vector<const marker_cl*> categoryMarkers;
+    // pDataX is in ascending order (LINES mode: allows to skip invisible points)
+    bool xSorted = false;
+    // data reordered for rendering (NULL: none)
+    const mortonOrder_cl* pReordered = NULL;
+    // pre-scaled coordinates (NULL: none)
+    const pixCoords_cl* pPixCoords = NULL;
+    // finite range of X / Y data over the first nRanged points, for autoscale. Extended on demand (see updateDataRange)
+    mutable size_t nRanged = 0;
+    mutable double rangeX0 = std::numeric_limits<double>::infinity();
+    mutable double rangeX1 = -std::numeric_limits<double>::infinity();
+    mutable double rangeY0 = std::numeric_limits<double>::infinity();
+    mutable double rangeY1 = -std::numeric_limits<double>::infinity();
+
+    // extends rangeX0..rangeY1 to all points
+    void updateDataRange() const {
+        const size_t n = getNPoints();
+        if (nRanged == n)
+            return;
+        if (pDataX)
+            updateRange(*pDataX, rangeX0, rangeX1, nRanged);
+        updateRange(*pDataY, rangeY0, rangeY1, nRanged);
+        nRanged = n;
+    }
+
+    // extends colorMin..colorMax to include the finite colors of points ixBegin.. (no valid data: 0..0)
+    void updateColorRange(size_t ixBegin) {
+        float c0 = std::numeric_limits<float>::infinity();
+        float c1 = -std::numeric_limits<float>::infinity();
+        const float* pC = pColorData->getNative<float>();
+        for (size_t ix = ixBegin; ix < pColorData->size(); ++ix) {
+            const float v = pC[ix];
+            if (!std::isinf(v) && !std::isnan(v)) {
+                c0 = std::min(c0, v);
+                c1 = std::max(c1, v);
+            }
+        }
+        if (c0 <= c1) {
+            colorMin = hasColorValues ? std::min(colorMin, c0) : c0;
+            colorMax = hasColorValues ? std::max(colorMax, c1) : c1;
+            hasColorValues = true;
+        } else if (!hasColorValues)
+            colorMin = colorMax = 0;  // no valid data
+    }
+
+    // whether data is in ascending order from element ixBegin (as float, like the kernels)
+    static bool isSorted(const column_cl& data, size_t ixBegin) {
+        float prev = -std::numeric_limits<float>::infinity();
+        vector<float> buf;
+        for (size_t ix = ixBegin, ixEnd; ix < data.size(); ix = ixEnd) {
+            ixEnd = std::min((ix / column_cl::chunkSize + 1) * column_cl::chunkSize, data.size());
+            const float* p = data.getChunk<float>(ix, ixEnd, buf);
+            if ((p[0] < prev) || !std::is_sorted(p, p + (ixEnd - ix)))
+                return false;
+            prev = p[ixEnd - ix - 1];
+        }
+        return true;
+    }
+
+    // extends v0..v1 to include the finite values of data from element ixBegin (read in its native type, rebased: per chunk)
+    static void updateRange(const column_cl& data, double& v0, double& v1, size_t ixBegin = 0) {
+        if (data.isRebased()) {
+            vector<float> buf;
+            for (size_t ixEnd; ixBegin < data.size(); ixBegin = ixEnd) {
+                ixEnd = std::min((ixBegin / column_cl::chunkSize + 1) * column_cl::chunkSize, data.size());
+                const double origin = data.getOrigin(ixBegin);
+                double c0 = std::numeric_limits<double>::infinity();
+                double c1 = -std::numeric_limits<double>::infinity();
+                updateRangeOf(data.getChunkRelative(ixBegin, ixEnd, origin, buf), ixEnd - ixBegin, c0, c1);
+                if (c0 <= c1) {
+                    v0 = std::min(v0, origin + c0);
+                    v1 = std::max(v1, origin + c1);
+                }
+            }
+            return;
+        }
+        if (ixBegin < data.size())
+            data.visit([&data, &v0, &v1, ixBegin](const auto* p) { updateRangeOf(p + ixBegin, data.size() - ixBegin, v0, v1); });
+    }
+
+    // extends v0..v1 to include the finite values of p[0..n-1]
+    template <typename T>
+    static void updateRangeOf(const T* p, size_t n, double& v0, double& v1) {
+        for (size_t ix = 0; ix < n; ++ix) {
+            const double v = (double)p[ix];
+            if (!std::isinf(v) && !std::isnan(v)) {
+                v0 = std::min(v0, v);
+                v1 = std::max(v1, v);
+            }
+        }
+    }
+
+    // index of the first element of sorted data that is not less than v (upper: greater than v)
+    static size_t lowerBound(const column_cl& data, double v, bool upper) {
+        size_t ixBegin = 0;
+        size_t ixEnd = data.size();
+        while (ixBegin < ixEnd) {
+            const size_t ixMid = ixBegin + (ixEnd - ixBegin) / 2;
+            const double d = data.at<double>(ixMid);
+            if (upper ? !(v < d) : (d < v))
+                ixBegin = ixMid + 1;
+            else
+                ixEnd = ixMid;
+        }
+        return ixBegin;
+    }
 
     // determines pixel distance squared between xData/yData (data coordinates) and xScreen/yScreen (screen coordinates)
     static int projectedDeltaSquare(const proj<float>& p, float xData, float yData, int xScreen, int yScreen) {
@@ -21,6 +21,11 @@ class marker_cl {
             seq.push_back(sequence[ix] != ' ');
     }
 
+    // true if both markers differ at most in color
+    bool sameShape(const marker_cl& other) const {
+        return (dxMinus == other.dxMinus) && (dxPlus == other.dxPlus) && (dyMinus == other.dyMinus) && (dyPlus == other.dyPlus) && (seq == other.seq);
+    }
+
     // marker is given as const - use public fields
     int dxMinus;
     int dxPlus;
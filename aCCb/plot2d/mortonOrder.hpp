@@ -0,0 +1,184 @@
+#pragma once
+#include <algorithm>  // min, max
+#include <cmath>      // isfinite
+#include <cstdint>
+#include <future>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "column.hpp"
+using std::vector;
+
+// copy of trace data, reordered along a Z-order (Morton) curve of the point locations.
+// Consecutive points are close on screen, therefore pixel writes are mostly local (cache, TLB).
+class mortonOrder_cl {
+   public:
+    // pDataX NULL: implicit X 1, 2, ..., N. pMask / pCategory are optional
+    mortonOrder_cl(const column_cl* pDataX, const column_cl& dataY, const column_cl* pMask, const column_cl* pCategory) {
+        const size_t n = dataY.size();
+        if (n > std::numeric_limits<uint32_t>::max())
+            throw std::runtime_error("reorder: too many points");
+        if ((pDataX && (pDataX->size() != n)) || (pMask && (pMask->size() != n)) || (pCategory && (pCategory->size() != n)))
+            throw std::runtime_error("reorder: inconsistent trace data size");
+
+        // === Z-order code on coordinates quantized to 16 bits over the data range ===
+        float x0, x1, y0, y1;
+        getRange(pDataX, n, x0, x1);
+        getRange(&dataY, n, y0, y1);
+        const float xScale = (x1 > x0) ? 65535.0f / (x1 - x0) : 0.0f;
+        const float yScale = (y1 > y0) ? 65535.0f / (y1 - y0) : 0.0f;
+        vector<uint32_t> codes(n);
+        perm.resize(n);
+        parallelBlocks(n, [&](size_t ixBegin, size_t ixEnd) {
+            vector<float> bufX;
+            vector<float> bufY;
+            const float* pX = pDataX ? pDataX->getChunk<float>(ixBegin, ixEnd, bufX) : NULL;
+            const float* pY = dataY.getChunk<float>(ixBegin, ixEnd, bufY);
+            for (size_t ix = ixBegin; ix < ixEnd; ++ix) {
+                const float x = pX ? pX[ix - ixBegin] : (float)(ix + 1);
+                const float y = pY[ix - ixBegin];
+                perm[ix] = (uint32_t)ix;
+                if (!std::isfinite(x) || !std::isfinite(y))
+                    codes[ix] = std::numeric_limits<uint32_t>::max();  // never drawn. Sort to the end
+                else
+                    codes[ix] = (spreadBits(quantize(x, x0, xScale)) << 1) | spreadBits(quantize(y, y0, yScale));
+            }
+        });
+
+        // === sort ===
+        radixSort(codes, perm);
+
+        // === reordered copies ===
+        this->x.resize(n);
+        this->y.resize(n);
+        if (pMask)
+            mask.resize(n);
+        if (pCategory)
+            category.resize(n);
+        parallelBlocks(n, [&](size_t ixBegin, size_t ixEnd) {
+            for (size_t ix = ixBegin; ix < ixEnd; ++ix) {
+                const uint32_t ixOrig = perm[ix];
+                this->x[ix] = pDataX ? pDataX->at<float>(ixOrig) : (float)(ixOrig + 1);
+                this->y[ix] = dataY.at<float>(ixOrig);
+                if (pMask)
+                    mask[ix] = pMask->at<uint16_t>(ixOrig);
+                if (pCategory)
+                    category[ix] = pCategory->at<uint16_t>(ixOrig);
+            }
+        });
+    }
+
+    // original index by position in the reordered data
+    vector<uint32_t> perm;
+    // reordered data (x is always present)
+    vector<float> x;
+    vector<float> y;
+    // reordered mask (empty if none)
+    vector<uint16_t> mask;
+    // reordered category (empty if none)
+    vector<uint16_t> category;
+
+   protected:
+    // range of finite values (pData NULL: implicit 1..n)
+    static void getRange(const column_cl* pData, size_t n, float& v0, float& v1) {
+        if (!pData) {
+            v0 = 1.0f;
+            v1 = (float)n;
+            return;
+        }
+        v0 = std::numeric_limits<float>::infinity();
+        v1 = -std::numeric_limits<float>::infinity();
+        pData->forEachChunk<float>([&v0, &v1](size_t, const float* p, size_t nChunk) {
+            for (size_t ix = 0; ix < nChunk; ++ix) {
+                const float v = p[ix];
+                if (std::isfinite(v)) {
+                    v0 = std::min(v0, v);
+                    v1 = std::max(v1, v);
+                }
+            }
+        });
+        if (v0 > v1)
+            v0 = v1 = 0;
+    }
+
+    static inline uint32_t quantize(float v, float v0, float scale) {
+        return (uint32_t)std::min(std::max((v - v0) * scale, 0.0f), 65535.0f);
+    }
+
+    // inserts a zero bit above each of the lower 16 bits
+    static inline uint32_t spreadBits(uint32_t v) {
+        v = (v | (v << 8)) & 0x00FF00FF;
+        v = (v | (v << 4)) & 0x0F0F0F0F;
+        v = (v | (v << 2)) & 0x33333333;
+        v = (v | (v << 1)) & 0x55555555;
+        return v;
+    }
+
+    // stable LSD radix sort by key, 8 bits per pass. Histograms and scatter run in parallel on blocks of the data
+    static void radixSort(vector<uint32_t>& keys, vector<uint32_t>& vals) {
+        const size_t n = keys.size();
+        const size_t nBlocks = getNBlocks(n);
+        const size_t blockSize = (n + nBlocks - 1) / nBlocks;
+        vector<uint32_t> keysTmp(n);
+        vector<uint32_t> valsTmp(n);
+        vector<vector<size_t>> offsets(nBlocks, vector<size_t>(256));
+        for (int shift = 0; shift < 32; shift += 8) {
+            // === histogram per block ===
+            runBlocks(nBlocks, [&](size_t ixBlock) {
+                vector<size_t>& h = offsets[ixBlock];
+                std::fill(h.begin(), h.end(), 0);
+                const size_t ixEnd = std::min((ixBlock + 1) * blockSize, n);
+                for (size_t ix = ixBlock * blockSize; ix < ixEnd; ++ix)
+                    ++h[(keys[ix] >> shift) & 0xFF];
+            });
+
+            // === start position per block and digit ===
+            size_t pos = 0;
+            for (size_t digit = 0; digit < 256; ++digit)
+                for (size_t ixBlock = 0; ixBlock < nBlocks; ++ixBlock) {
+                    size_t count = offsets[ixBlock][digit];
+                    offsets[ixBlock][digit] = pos;
+                    pos += count;
+                }
+
+            // === scatter ===
+            runBlocks(nBlocks, [&](size_t ixBlock) {
+                vector<size_t>& o = offsets[ixBlock];
+                const size_t ixEnd = std::min((ixBlock + 1) * blockSize, n);
+                for (size_t ix = ixBlock * blockSize; ix < ixEnd; ++ix) {
+                    const size_t dest = o[(keys[ix] >> shift) & 0xFF]++;
+                    keysTmp[dest] = keys[ix];
+                    valsTmp[dest] = vals[ix];
+                }
+            });
+            keys.swap(keysTmp);
+            vals.swap(valsTmp);
+        }
+    }
+
+    static size_t getNBlocks(size_t n) {
+        const size_t nThreads = std::max(std::thread::hardware_concurrency(), 1u);
+        return std::max(std::min(nThreads, n / 65536), (size_t)1);
+    }
+
+    // runs fn(ixBlock) for 0..nBlocks-1 in parallel
+    template <typename fn_t>
+    static void runBlocks(size_t nBlocks, fn_t fn) {
+        vector<std::future<void>> futs;
+        for (size_t ixBlock = 1; ixBlock < nBlocks; ++ixBlock)
+            futs.push_back(std::async(fn, ixBlock));
+        fn(0);
+        for (std::future<void>& f : futs)
+            f.get();
+    }
+
+    // runs fn(ixBegin, ixEnd) in parallel on blocks of 0..n-1
+    template <typename fn_t>
+    static void parallelBlocks(size_t n, fn_t fn) {
+        const size_t nBlocks = getNBlocks(n);
+        const size_t blockSize = (n + nBlocks - 1) / nBlocks;
+        runBlocks(nBlocks, [&fn, blockSize, n](size_t ixBlock) { fn(ixBlock * blockSize, std::min((ixBlock + 1) * blockSize, n)); });
+    }
+};
@@ -1,6 +1,9 @@
 #pragma once
+#include <type_traits>
 template <typename T>
 class proj {
+    template <typename>
+    friend class proj;
     T dataX0, dataY0, dataX1, dataY1;
     int screenX0, screenY0, screenX1, screenY1;
     T mXData2screen;
@@ -29,27 +32,93 @@ class proj {
           bYData2screen(screenY0 - dataY0 * (screenY1 - screenY0) / (dataY1 - dataY0)),
           bYData2screenPlus0p5(bYData2screen + (T)0.5) {}
 
+    //** the same view in another type (data limits are converted, then the transformation is computed in T) */
+    template <typename T2>
+    explicit proj(const proj<T2>& p) : proj(p.getDataX0(), p.getDataY0(), p.getDataX1(), p.getDataY1(), p.getScreenX0(), p.getScreenY0(), p.getScreenX1(), p.getScreenY1()) {}
+
     proj() {} 
+
+    //** the same transformation in type T2, for data given as origin + step * v (e.g. float offsets from a double origin: step 1, or 16 bit codes).
+    // The offset term is computed in T, therefore the result is precise near the origin, also where the data limits are not in T2 */
+    template <typename T2>
+    proj<T2> rebased(T oX, T oY, T stepX = 1, T stepY = 1) const {
+        proj<T2> r;
+        r.dataX0 = (T2)((dataX0 - oX) / stepX);
+        r.dataY0 = (T2)((dataY0 - oY) / stepY);
+        r.dataX1 = (T2)((dataX1 - oX) / stepX);
+        r.dataY1 = (T2)((dataY1 - oY) / stepY);
+        r.screenX0 = screenX0;
+        r.screenY0 = screenY0;
+        r.screenX1 = screenX1;
+        r.screenY1 = screenY1;
+        const T bX = screenX0 + (oX - dataX0) * mXData2screen;
+        const T bY = screenY0 + (oY - dataY0) * mYData2screen;
+        r.mXData2screen = (T2)(mXData2screen * stepX);
+        r.bXData2screen = (T2)bX;
+        r.bXData2screenPlus0p5 = (T2)(bX + (T)0.5);
+        r.mYData2screen = (T2)(mYData2screen * stepY);
+        r.bYData2screen = (T2)bY;
+        r.bYData2screenPlus0p5 = (T2)(bY + (T)0.5);
+        return r;
+    }
     //** projects data to screen */
     inline int projX(T x) const {
-        return x * mXData2screen + bXData2screenPlus0p5;
+        if constexpr (std::is_same_v<T, double>)
+            return (x - dataX0) * mXData2screen + (screenX0 + 0.5);  // (precise also far from data 0, e.g. timestamps)
+        else
+            return x * mXData2screen + bXData2screenPlus0p5;
     }
     //** projects data to screen */
     inline int projY(T y) const {
-        return y * mYData2screen + bYData2screenPlus0p5;
+        if constexpr (std::is_same_v<T, double>)
+            return (y - dataY0) * mYData2screen + (screenY0 + 0.5);
+        else
+            return y * mYData2screen + bYData2screenPlus0p5;
+    }
+
+    //** projects data to screen, without rounding to int (pixel is floor of result) */
+    inline T projXf(T x) const {
+        if constexpr (std::is_same_v<T, double>)
+            return (x - dataX0) * mXData2screen + (screenX0 + 0.5);
+        else
+            return x * mXData2screen + bXData2screenPlus0p5;
+    }
+    //** projects data to screen, without rounding to int (pixel is floor of result) */
+    inline T projYf(T y) const {
+        if constexpr (std::is_same_v<T, double>)
+            return (y - dataY0) * mYData2screen + (screenY0 + 0.5);
+        else
+            return y * mYData2screen + bYData2screenPlus0p5;
+    }
+
+    //** screen pixels per data unit */
+    inline T getScaleX() const {
+        return mXData2screen;
+    }
+    //** screen pixels per data unit */
+    inline T getScaleY() const {
+        return mYData2screen;
+    }
+    //** screen position of data 0 (+0.5 for rounding, see projX) */
+    inline T getOffsetX() const {
+        return bXData2screenPlus0p5;
+    }
+    //** screen position of data 0 (+0.5 for rounding, see projY) */
+    inline T getOffsetY() const {
+        return bYData2screenPlus0p5;
     }
 
     //* projects screen to data */
     inline T unprojX(int xMouse) const {
         xMouse = std::min(xMouse, std::max(screenX0, screenX1));
         xMouse = std::max(xMouse, std::min(screenX0, screenX1));
-        return (xMouse - bXData2screen) / mXData2screen;
+        return dataX0 + (xMouse - screenX0) / mXData2screen;
     }
     //* projects screen to data */
     inline T unprojY(int yMouse) const {
         yMouse = std::min(yMouse, std::max(screenY0, screenY1));
         yMouse = std::max(yMouse, std::min(screenY0, screenY1));
-        return (yMouse - bYData2screen) / mYData2screen;
+        return dataY0 + (yMouse - screenY0) / mYData2screen;
     }
     inline int getScreenWidth() const {
         return std::abs(screenX1 - screenX0);
@@ -1,6 +1,7 @@
 #pragma once
 #include <algorithm>
 #include <string>
+#include <vector>
 namespace aCCb {
 bool caseInsensitiveStringCompare(const std::string &str1, const std::string &str2) {
     std::string str1Cpy(str1);
@@ -9,4 +10,19 @@ bool caseInsensitiveStringCompare(const std::string &str1, const std::string &st
     std::transform(str2Cpy.begin(), str2Cpy.end(), str2Cpy.begin(), ::tolower);
     return str1Cpy == str2Cpy;
 }
+
+// splits at each occurrence of sep (empty string: no fields)
+std::vector<std::string> split(const std::string &str, char sep) {
+    std::vector<std::string> r;
+    if (str.empty())
+        return r;
+    size_t ixBegin = 0;
+    while (true) {
+        size_t ixSep = str.find(sep, ixBegin);
+        r.push_back(str.substr(ixBegin, ixSep - ixBegin));
+        if (ixSep == std::string::npos)
+            return r;
+        ixBegin = ixSep + 1;
+    }
+}
 }  // namespace aCCb
\ No newline at end of file
@@ -3,8 +3,11 @@
 #include <stdlib.h>
 
 #include <filesystem>
+#include <functional>
 #include <iostream>
+#include <memory>
 #include <regex>
+#include <set>
 #include <stdexcept>
 #include <string>
 #include <vector>
@@ -12,14 +15,16 @@
 #include "aCCb/binIo.hpp"
 #include "aCCb/cmdLineParsing.hpp"
 #include "aCCb/plot2d.hpp"
-#include "aCCb/plot2d/syncFile.hpp"
 #include "aCCb/stringToNum.hpp"
 #include "aCCb/stringUtil.hpp"
 #include "aCCb/vectorText.hpp"
 #include "aCCb/widget.hpp"
 #include "fooplot/cmdLineProcessor.hpp"
+#include "fooplot/controlServer.hpp"
+#include "fooplot/fileWatch.hpp"
 #include "fooplot/markerMan.hpp"
 #include "fooplot/testcase.hpp"
+#include "fooplot/traceBuilder.hpp"
 #include "fooplot/traceMan.hpp"
 using std::string, std::vector, std::array, std::cout, std::endl, std::runtime_error, std::map, std::pair, std::cerr;
 
@@ -62,7 +67,7 @@ class myMenu : public aCCbWidget {
 // fooplot window started using data structure from parsing cmd line args
 class fooplotWindow {
    public:
-    fooplotWindow(fooplotCmdLineArgRoot &l, allDrawJobs_cl &adr) : syncfile(l.syncfile), persistfile(l.persistfile) {
+    fooplotWindow(fooplotCmdLineArgRoot &l, allDrawJobs_cl &adr) : persistfile(l.persistfile), streamViewSpan(l.streamViewSpan), following(l.streamView != "none") {
         // === main window ===
         int areaW, areaH;
         if ((l.windowX > 0) && (l.windowY > 0) && (l.windowW > 0) && (l.windowH > 0)) {
@@ -102,27 +107,22 @@ class fooplotWindow {
         tb->setXlabel(l.xlabel);
         tb->setYlabel(l.ylabel);
 
-        bool needAutoscaleX0 = std::isnan(l.xLimLow);
-        bool needAutoscaleX1 = std::isnan(l.xLimHigh);
-        if (needAutoscaleX0 | needAutoscaleX1) {
-            bool success = tb->autoscaleX(needAutoscaleX0, needAutoscaleX1);
-            if (!success)
-                tb->autoscaleX(true, true);
-        }
-
-        bool needAutoscaleY0 = std::isnan(l.yLimLow);
-        bool needAutoscaleY1 = std::isnan(l.yLimHigh);
-        if (needAutoscaleY0 | needAutoscaleY1) {
-            bool success = tb->autoscaleY(needAutoscaleY0, needAutoscaleY1);
-            if (!success)
-                tb->autoscaleY(true, true);
-        }
+        needAutoscaleX0 = std::isnan(l.xLimLow);
+        needAutoscaleX1 = std::isnan(l.xLimHigh);
+        needAutoscaleY0 = std::isnan(l.yLimLow);
+        needAutoscaleY1 = std::isnan(l.yLimHigh);
+        autoscale();
+        followedView = {tb->x0, tb->y0, tb->x1, tb->y1};
 
         // this->menu = new myMenu(800, 0, 400, 200);
         // menu->box(Fl_Boxtype::FL_BORDER_FRAME);
         // menu->color(FL_GREEN);
         window->resizable(tb);
         window->end();
+        if (l.syncfile != "")
+            syncfile = watch.add(l.syncfile);
+        if (watch.getFd() >= 0)
+            Fl::add_fd(watch.getFd(), FL_READ, cb_watchWrapper, (void *)this);
         Fl::add_timeout(0.1, cb_timerWrapper, (void *)this);
     }
 
@@ -130,6 +130,28 @@ class fooplotWindow {
         window->show();
     }
 
+    // polls fn for new data (streamed input), which returns true if it has changed trace data
+    void setDataUpdate(std::function<bool()> fn) {
+        dataUpdate = fn;
+        Fl::add_timeout(dataUpdateInterval_s, cb_dataTimerWrapper, (void *)this);
+    }
+
+    // reloads data files when they change (-reload): fn reloads the given files and returns true if trace data has changed.
+    // With -sync, changes are collected until the sync file changes, otherwise until writing has paused
+    void setReload(const vector<string> &files, std::function<bool(const vector<string> &)> fn) {
+        reload = fn;
+        for (const string &f : files)
+            dataFiles.insert(watch.add(f));
+    }
+
+    // accepts commands on a Unix domain socket (-control) that change the traces and the view, see control()
+    void setControl(const string &socketPath, traceBuilder_cl &traceBuilder, traceDataMan_cl &traceDataMan, allDrawJobs_cl &allDrawJobs) {
+        this->traceBuilder = &traceBuilder;
+        this->traceDataMan = &traceDataMan;
+        this->allDrawJobs = &allDrawJobs;
+        controlServer = std::make_unique<controlServer_cl>(socketPath, [this](const vector<string> &args) { return control(args); });
+    }
+
     void cb_close() {
         window->hide();
     }
@@ -137,6 +159,11 @@ class fooplotWindow {
     void shutdown() {
         // need to stop background processes, before removal of the window triggers destructors
         Fl::remove_timeout(cb_timerWrapper);
+        Fl::remove_timeout(cb_dataTimerWrapper);
+        Fl::remove_timeout(cb_reloadWrapper);
+        if (watch.getFd() >= 0)
+            Fl::remove_fd(watch.getFd());
+        controlServer.reset();
         tb->shutdown();
     }
 
@@ -146,10 +173,9 @@ class fooplotWindow {
     }
 
     void cb_timer() {
-        if (syncfile.isModified())
-            cb_close();  // all windows are hidden => Fl::run() returns
-        else
-            Fl::repeat_timeout(0.5, cb_timerWrapper, (void *)this);
+        if (watch.needsPolling())
+            filesChanged(watch.getChanged());  // (no change notification: poll)
+        Fl::repeat_timeout(0.5, cb_timerWrapper, (void *)this);
 
         if (persistfile != "") {
             std::stringstream ss;
@@ -171,6 +197,39 @@ class fooplotWindow {
         ((fooplotWindow *)userdata)->cb_timer();
     }
 
+    void cb_dataTimer() {
+        tb->updateData([this]() {
+            if (!dataUpdate())
+                return false;
+            followData();
+            return true;
+        });
+        Fl::repeat_timeout(dataUpdateInterval_s, cb_dataTimerWrapper, (void *)this);
+    }
+
+    static void cb_dataTimerWrapper(void *userdata) {
+        assert(userdata);
+        ((fooplotWindow *)userdata)->cb_dataTimer();
+    }
+
+    static void cb_watchWrapper(int /*fd*/, void *userdata) {
+        assert(userdata);
+        fooplotWindow *this_ = (fooplotWindow *)userdata;
+        this_->filesChanged(this_->watch.getChanged());
+    }
+
+    // reloads the changed data files, keeping view and cursor
+    void cb_reload() {
+        const vector<string> files(pendingReload.begin(), pendingReload.end());
+        pendingReload.clear();
+        tb->updateData([this, &files]() { return reload(files); });
+    }
+
+    static void cb_reloadWrapper(void *userdata) {
+        assert(userdata);
+        ((fooplotWindow *)userdata)->cb_reload();
+    }
+
     ~fooplotWindow() {
         delete this->window;  // deletes children recursively
     }
@@ -179,9 +238,224 @@ class fooplotWindow {
    protected:
     aCCbWidget *menu;
     Fl_Double_Window *window;
-    syncFile_t syncfile;
+    // sync file (-sync) and data files (-reload)
+    fileWatch_cl watch;
+    // as reported by watch (empty: none)
+    string syncfile;
+    // see setReload
+    std::function<bool(const vector<string> &)> reload;
+    // as reported by watch, see setReload
+    std::set<string> dataFiles;
+    // data files that have changed since the last reload
+    std::set<string> pendingReload;
+    // (-reload without -sync) writing has paused when no file has changed for this time
+    const double reloadDelay_s = 0.1;
+    // see setControl
+    std::unique_ptr<controlServer_cl> controlServer;
+    traceBuilder_cl *traceBuilder = NULL;
+    traceDataMan_cl *traceDataMan = NULL;
+    allDrawJobs_cl *allDrawJobs = NULL;
     string persistfile;
     string persistFileContents;
+    // see setDataUpdate
+    std::function<bool()> dataUpdate;
+    const double dataUpdateInterval_s = 0.2;
+    // limits without -xLimLow etc.
+    bool needAutoscaleX0;
+    bool needAutoscaleX1;
+    bool needAutoscaleY0;
+    bool needAutoscaleY1;
+    // -streamView (number): width of the X range that follows the newest data (NAN: all data)
+    double streamViewSpan;
+    // the view follows new data, until the user changes it (-streamView)
+    bool following;
+    // x0, y0, x1, y1 as last set by autoscale
+    std::array<double, 4> followedView;
+
+    // handles changes of watched files: a change of the sync file closes the plot (-reload: reloads changed data files), see setReload
+    void filesChanged(const vector<string> &files) {
+        bool sync = false;
+        for (const string &f : files) {
+            sync |= (f == syncfile);
+            if (dataFiles.count(f))
+                pendingReload.insert(f);  // (may also be the sync file)
+        }
+        if (sync && !reload) {
+            cb_close();  // all windows are hidden => Fl::run() returns
+            return;
+        }
+        if (pendingReload.empty())
+            return;
+        if (sync)
+            cb_reload();
+        else if (syncfile == "") {
+            // === wait until writing has paused ===
+            Fl::remove_timeout(cb_reloadWrapper);
+            Fl::add_timeout(reloadDelay_s, cb_reloadWrapper, (void *)this);
+        }
+    }
+
+    // runs a command from the control socket (see setControl, README). Returns its result
+    string control(const vector<string> &args) {
+        if (args.empty())
+            return "";
+        const string &cmd = args[0];
+        const vector<string> cmdArgs(args.begin() + 1, args.end());
+        if ((cmd != "") && (cmd[0] == '-'))
+            return controlArgs(args);
+        if (cmd == "add") {
+            const trace t = parseTrace(cmdArgs);
+            changeTraces([this, &t]() {
+                traceBuilder->announce(t);
+                traceBuilder->add(t, *allDrawJobs);
+            });
+            return std::to_string(traceBuilder->getNTraces());
+        }
+        if ((cmd == "replace") || (cmd == "remove")) {
+            size_t n;
+            if (cmdArgs.empty() || !aCCb::str2num(cmdArgs[0], n) || (n < 1))
+                throw aCCb::argObjException(cmd + ": expecting a trace number (first trace: 1)");
+            if (cmd == "remove") {
+                if (cmdArgs.size() != 1)
+                    throw aCCb::argObjException("remove: unexpected argument '" + cmdArgs[1] + "'");
+                changeTraces([this, n]() { traceBuilder->remove(n - 1, *allDrawJobs); });
+                return "";
+            }
+            const trace t = parseTrace(vector<string>(cmdArgs.begin() + 1, cmdArgs.end()));
+            changeTraces([this, &t, n]() {
+                traceBuilder->announce(t);
+                traceBuilder->replace(n - 1, t, *allDrawJobs);
+            });
+            return "";
+        }
+        if (cmd == "view") {
+            double v[4];
+            if ((cmdArgs.size() == 1) && (cmdArgs[0] == "auto")) {
+                tb->autoscaleX(true, true);
+                tb->autoscaleY(true, true);
+                tb->setView(tb->x0, tb->y0, tb->x1, tb->y1);
+            } else if ((cmdArgs.size() == 4) && aCCb::str2num(cmdArgs[0], v[0]) && aCCb::str2num(cmdArgs[1], v[1]) && aCCb::str2num(cmdArgs[2], v[2]) && aCCb::str2num(cmdArgs[3], v[3]))
+                tb->setView(v[0], v[1], v[2], v[3]);
+            else
+                throw aCCb::argObjException("view: expecting x0 y0 x1 y1 or auto");
+            following = false;
+            return "";
+        }
+        if (cmd == "screenshot") {
+            if (cmdArgs.size() != 1)
+                throw aCCb::argObjException("screenshot: expecting a filename (.ppm)");
+            screenshot(cmdArgs[0]);
+            return "";
+        }
+        throw aCCb::argObjException("unknown command '" + cmd + "'. Valid: add, replace, remove, view, screenshot or command line arguments");
+    }
+
+    // command line arguments from the control socket: -trace adds traces (returns their numbers), title and labels change, limits move the view
+    string controlArgs(const vector<string> &args) {
+        fooplotCmdLineArgRoot l(/*atRunTime*/ true);
+        for (const string &a : args)
+            if (!l.acceptArg(a))
+                throw aCCb::argObjException("unexpected argument '" + a + "'");
+        l.close();
+
+        string r;
+        if (!l.traces.empty())
+            changeTraces([this, &l, &r]() {
+                for (const trace &t : l.traces)
+                    traceBuilder->announce(t);
+                for (const trace &t : l.traces) {
+                    traceBuilder->add(t, *allDrawJobs);
+                    r += (r == "" ? "" : " ") + std::to_string(traceBuilder->getNTraces());
+                }
+            });
+        if (l.title != "") {
+            tb->setTitle(l.title);
+            window->copy_label(l.title.c_str());
+        }
+        if (l.xlabel != "")
+            tb->setXlabel(l.xlabel);
+        if (l.ylabel != "")
+            tb->setYlabel(l.ylabel);
+        if (!std::isnan(l.xLimLow) || !std::isnan(l.xLimHigh) || !std::isnan(l.yLimLow) || !std::isnan(l.yLimHigh)) {
+            tb->setView(std::isnan(l.xLimLow) ? tb->x0 : l.xLimLow,
+                        std::isnan(l.yLimLow) ? tb->y0 : l.yLimLow,
+                        std::isnan(l.xLimHigh) ? tb->x1 : l.xLimHigh,
+                        std::isnan(l.yLimHigh) ? tb->y1 : l.yLimHigh);
+            following = false;
+        }
+        tb->invalidate(/*full redraw*/ true);
+        return r;
+    }
+
+    // -trace arguments (without -trace) from the control socket
+    static trace parseTrace(const vector<string> &args) {
+        trace t;
+        for (const string &a : args)
+            if (!t.acceptArg(a))
+                throw aCCb::argObjException("unexpected trace argument '" + a + "'");
+        t.close();
+        return t;
+    }
+
+    // changes traces via fn while point lookup is held off, then watches the data files of new traces (-reload)
+    void changeTraces(std::function<void()> fn) {
+        tb->updateData([&fn]() {
+            fn();
+            return true;
+        });
+        if (reload)
+            for (const string &f : traceDataMan->getSourceFiles())
+                dataFiles.insert(watch.add(f));
+    }
+
+    // writes the window contents as binary PPM
+    void screenshot(const string &filename) {
+        Fl::flush();  // (pending redraw)
+        window->make_current();
+        const int w = window->w();
+        const int h = window->h();
+        std::unique_ptr<uchar[]> rgb(fl_read_image(NULL, 0, 0, w, h));
+        if (!rgb)
+            throw runtime_error("screenshot: failed to read the window");
+        std::ofstream f(filename, std::ios::binary);
+        f << "P6\n"
+          << w << " " << h << "\n255\n";
+        f.write((const char *)rgb.get(), (std::streamsize)3 * w * h);
+        if (!f)
+            throw runtime_error("screenshot: failed to write " + filename);
+    }
+
+    // autoscales the limits that are not given on the command line
+    void autoscale() {
+        if (needAutoscaleX0 | needAutoscaleX1) {
+            bool success = tb->autoscaleX(needAutoscaleX0, needAutoscaleX1);
+            if (!success)
+                tb->autoscaleX(true, true);
+        }
+
+        if (needAutoscaleY0 | needAutoscaleY1) {
+            bool success = tb->autoscaleY(needAutoscaleY0, needAutoscaleY1);
+            if (!success)
+                tb->autoscaleY(true, true);
+        }
+    }
+
+    // moves the view to new data (-streamView), unless the user has changed it
+    void followData() {
+        if (!following)
+            return;
+        if (followedView != std::array<double, 4>{tb->x0, tb->y0, tb->x1, tb->y1}) {
+            following = false;  // zoomed or panned
+            return;
+        }
+        autoscale();
+        if (!std::isnan(streamViewSpan)) {
+            tb->autoscaleX(true, true);
+            tb->x0 = tb->x1 - streamViewSpan;
+        }
+        tb->setView(tb->x0, tb->y0, tb->x1, tb->y1);
+        followedView = {tb->x0, tb->y0, tb->x1, tb->y1};
+    }
 };
 
 //* returns file contents split by whitespace */
@@ -203,25 +477,43 @@ vector<string> readPersistFileTokens(const string &filename) {
 void usage() {
     cerr << "usage:" << endl;
     cerr << "-trace" << endl;
-    cerr << "   -dataX (filename)" << endl;
-    cerr << "   -dataY (filename)" << endl;
+    cerr << "   -dataX (filename see [2])" << endl;
+    cerr << "   -dataY (filename see [2])" << endl;
     cerr << "   -vertLineY (number) repeated use is allowed" << endl;
     cerr << "   -horLineX (number) repeated use is allowed" << endl;
     cerr << "   -marker (e.g. w.1 see [1])" << endl;
     cerr << "   -annot (filenameTxt)" << endl;
     cerr << "   -annot2 (filenameIndex) (filenameTxt)" << endl;
     cerr << "   -mask (filename) (value)" << endl;
+    cerr << "   -hide" << endl;
+    cerr << "   -density" << endl;
+    cerr << "   -lines" << endl;
+    cerr << "   -reorder" << endl;
+    cerr << "   -colormap (" << colormap_cl::getNames() << ")" << endl;
+    cerr << "   -colorData (filename)" << endl;
+    cerr << "   -colorRange (number) (number)" << endl;
+    cerr << "   -maskCategorical (filename) (palette e.g. 0:gx1,1:r.2 last on top)" << endl;
     cerr << "-xlabel (text)" << endl;
     cerr << "-ylabel (text)" << endl;
     cerr << "-title (text)" << endl;
     cerr << "-sync (filename)" << endl;
     cerr << "-persist (filename)" << endl;
     cerr << "-fontsize (number)" << endl;
+    cerr << "-cacheDir (directory) -cacheMaxMB (number)" << endl;
+    cerr << "-mmap" << endl;
+    cerr << "-compact" << endl;
+    cerr << "-panCache faster panning of large point data, at up to twice its memory" << endl;
+    cerr << "-follow plain binary and .txt data files are watched for appended data" << endl;
+    cerr << "-reload traces are reloaded when their data files are rewritten (with -sync: when the sync file changes)" << endl;
     cerr << "-windowX (number) -windowY (number) -windowW (number) -windowH(number)" << endl;
     cerr << "-xLimLow (number) -xLimHigh (number) -yLimLow (number) -yLimHigh (number)" << endl;
+    cerr << "-control (socket path) accepts commands on a Unix domain socket: add, replace, remove, view, screenshot, command line arguments" << endl;
+    cerr << "-streamView (all|none|number) view follows streamed data: all of it, not, or the newest (number) X range" << endl;
     cerr << endl;
     cerr << "[1] colors in place of 'w': krgbcmyaow" << endl;
     cerr << "    shapes in place of '.1': .1 .2 .3 +1 +2 x1 x2 ('1' can be omitted')" << endl;
+    cerr << "[2] a data filename may be a CSV / TSV column: file.csv:(header name or column index base 0)" << endl;
+    cerr << "    '-' reads numbers from stdin as they arrive (binary: -:type=float), as does a named pipe" << endl;
 }
 
 #if 0
@@ -318,50 +610,50 @@ int main2(int argc, const char **argv) {
 
     //* stores all trace data */
     traceDataMan_cl traceDataMan;
+    traceDataMan.setMapFiles(l.mmap);
+    traceDataMan.setCompact(l.compact);
+    traceDataMan.setFollow(l.follow);
+    if (l.cacheDir != "")
+        traceDataMan.setCacheDir(l.cacheDir, l.cacheMaxMB << 20);
 
     //* provides all markers */
     markerMan_cl markerMan;
 
+    //* creates the drawJobs, holds data they refer to (declared before allDrawJobs) */
+    traceBuilder_cl traceBuilder(traceDataMan, markerMan);
+
     //* all traces */
     allDrawJobs_cl allDrawJobs;
+    allDrawJobs.setPanCache(l.panCache);
 
-    for (auto t : l.traces) {
-        const marker_cl *marker = markerMan.getMarker(t.marker);
-        if (!marker)
-            throw aCCb::argObjException("invalid marker description '" + t.marker + "'. Valid example: g.1");
-
-        vector<drawJob::annotation_cl> annotations;
-        for (annot2args &aInput : t.annotations) {
-            const vector<uint32_t> *pMapping = NULL;
-            if (aInput.mapFilename != "")
-                pMapping = traceDataMan.getUInt32Vec(aInput.mapFilename);
-            drawJob::annotation_cl aData(pMapping, traceDataMan.getAsciiVec(aInput.annotTxtFilename));
-            annotations.push_back(aData);
-        }
+    // CSV columns of all traces are parsed together, one pass per file
+    for (auto t : l.traces)
+        traceBuilder.announce(t);
 
-        //* one trace */
-        const std::vector<float> *dataX = traceDataMan.getFloatVec(t.dataX);
-        const std::vector<float> *dataY = traceDataMan.getFloatVec(t.dataY);
-        if (dataX && !dataY)
-            throw aCCb::argObjException("-dataX without -dataY");
-
-        drawJob j(
-            dataX,
-            dataY,
-            annotations,
-            marker,
-            t.vertLineX,
-            t.horLineY,
-            traceDataMan.getUInt16Vec(t.maskFile),
-            t.maskVal);
-
-        allDrawJobs.addDrawJob(j);
-    }
+    for (auto t : l.traces)
+        traceBuilder.add(t, allDrawJobs);
 
     // === start up window ===
     // background thread running
     fooplotWindow w(l, allDrawJobs);
     windowForSigIntHandler = &w;
+    if (traceDataMan.hasStreams() || (l.controlSocket != ""))  // (-control: traces added later may stream)
+        w.setDataUpdate([&]() { return traceDataMan.updateStreams() && traceBuilder.update(allDrawJobs); });
+    if (l.reload)
+        w.setReload(traceDataMan.getSourceFiles(), [&](const vector<string> &files) {
+            std::set<string> reloaded;
+            for (const string &f : files) {
+                try {
+                    traceDataMan.reload(f);
+                    reloaded.insert(f);
+                } catch (std::exception &e) {
+                    cerr << "reload: keeping previous data of " << f << ": " << e.what() << endl;
+                }
+            }
+            return traceBuilder.reload(reloaded, allDrawJobs);
+        });
+    if (l.controlSocket != "")
+        w.setControl(l.controlSocket, traceBuilder, traceDataMan, allDrawJobs);
     w.show();
 
     // === main loop ===
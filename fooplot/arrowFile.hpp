@@ -0,0 +1,394 @@
+#pragma once
+#include <cstdint>
+#include <cstring>  // memcmp, memcpy
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../aCCb/cmdLineParsing.hpp"
+#include "../aCCb/mappedFile.hpp"
+#include "../aCCb/stringToNum.hpp"
+using std::string, std::vector;
+
+// columns of an uncompressed Arrow IPC file (Feather v2), memory-mapped. Numeric data is used in place.
+// Minimal reader for the flatbuffers metadata: footer, schema, record batch and dictionary batch messages.
+class arrowFile_cl {
+   public:
+    arrowFile_cl(const string &filename) : filename(filename), f(filename) {
+        // === magic, footer ===
+        const char *p = f.data();
+        const size_t n = f.size();
+        if ((n < 18) || (memcmp(p, "ARROW1", 6) != 0) || (memcmp(p + n - 6, "ARROW1", 6) != 0))
+            throw aCCb::argObjException("not an Arrow IPC file (Feather v2): " + filename);
+        const size_t footerLen = get<uint32_t>(n - 10);
+        if (footerLen + 10 > n)
+            throw aCCb::argObjException("invalid Arrow IPC footer: " + filename);
+        const size_t footerBegin = n - 10 - footerLen;
+        const table_cl footer = getRoot(footerBegin);
+        schema = footer.table(1);
+        if (!schema.valid())
+            throw aCCb::argObjException("Arrow IPC file has no schema: " + filename);
+        if (schema.get<int16_t>(0, 0) != 0)
+            throw aCCb::argObjException("big-endian Arrow IPC file is not supported: " + filename);
+        for (size_t ix = 0; ix < footer.vecLen(3); ++ix)
+            recordBatches.push_back(getBlock(footer, 3, ix));
+        for (size_t ix = 0; ix < footer.vecLen(2); ++ix)
+            dictionaryBatches.push_back(getBlock(footer, 2, ix));
+    }
+
+    // one record batch of a numeric column
+    struct chunk_t {
+        const char *pData;
+        // validity bitmap (NULL: no nulls)
+        const uint8_t *pValidity;
+        size_t length;
+    };
+
+    // numeric column (dictionary-encoded: the indices)
+    struct numColumn_t {
+        // element type as binary file extension e.g. ".float"
+        string type;
+        // data is a bitmap (type .uint8)
+        bool isBool = false;
+        vector<chunk_t> chunks;
+        size_t size = 0;
+        bool hasNulls = false;
+    };
+
+    // column by name or index (base 0)
+    numColumn_t getNumeric(const string &column) const {
+        const size_t ixField = getFieldIndex(column);
+        const table_cl field = schema.vecTable(1, ixField);
+        numColumn_t r;
+        const uint8_t typeType = field.get<uint8_t>(2, 0);
+        const table_cl type = field.table(3);
+        const table_cl dictionary = field.table(4);
+        if (dictionary.valid()) {
+            // === indices (default: int32) ===
+            const table_cl indexType = dictionary.table(1);
+            r.type = getIntType(indexType.valid() ? indexType.get<int32_t>(0, 32) : 32, indexType.valid() ? indexType.get<uint8_t>(1, 0) != 0 : true);
+        } else if (typeType == typeInt)
+            r.type = getIntType(type.get<int32_t>(0, 0), type.get<uint8_t>(1, 0) != 0);
+        else if (typeType == typeFloatingPoint) {
+            const int16_t precision = type.get<int16_t>(0, 0);
+            r.type = (precision == 1) ? ".float" : (precision == 2) ? ".double" : "";
+        } else if (typeType == typeBool) {
+            r.type = ".uint8";
+            r.isBool = true;
+        } else if (typeType == typeDate)
+            r.type = (type.get<int16_t>(0, 1) == 0) ? ".int32" : ".int64";  // (days or milliseconds)
+        else if (typeType == typeTime)
+            r.type = getIntType(type.get<int32_t>(1, 32), true);
+        else if ((typeType == typeTimestamp) || (typeType == typeDuration))
+            r.type = ".int64";
+        if (r.type == "")
+            throw aCCb::argObjException("Arrow column is not numeric (strings: use as -annot / -annot2 text): " + filename + ":" + column);
+
+        forEachBatch(ixField, [&](const table_cl &batch, size_t ixNode, size_t ixBuffer, size_t bodyBegin) {
+            chunk_t c;
+            c.length = batch.get<int64_t>(0, 0);
+            const int64_t nullCount = batch.at<int64_t>(batch.vecElem(1, ixNode, 16) + 8);
+            c.pValidity = (nullCount > 0) ? (const uint8_t *)getBuffer(batch, ixBuffer, bodyBegin, (c.length + 7) / 8) : NULL;
+            c.pData = getBuffer(batch, ixBuffer + 1, bodyBegin, r.isBool ? (c.length + 7) / 8 : c.length * getTypeSize(r.type));
+            r.chunks.push_back(c);
+            r.size += c.length;
+            r.hasNulls |= (nullCount > 0);
+        });
+        return r;
+    }
+
+    // strings of a column: one per row for a string column (null: empty), or the dictionary of a dictionary-encoded string column (see getNumeric for the indices)
+    vector<string> getStrings(const string &column) const {
+        const size_t ixField = getFieldIndex(column);
+        const table_cl field = schema.vecTable(1, ixField);
+        const uint8_t typeType = field.get<uint8_t>(2, 0);
+        if ((typeType != typeUtf8) && (typeType != typeLargeUtf8) && (typeType != typeBinary) && (typeType != typeLargeBinary))
+            throw aCCb::argObjException("Arrow column is not a string column: " + filename + ":" + column);
+        const bool large = (typeType == typeLargeUtf8) || (typeType == typeLargeBinary);
+        vector<string> r;
+        const table_cl dictionary = field.table(4);
+        if (dictionary.valid()) {
+            // === dictionary batches with the id of the field, in file order (delta batches append) ===
+            const int64_t id = dictionary.get<int64_t>(0, 0);
+            for (const block_t &b : dictionaryBatches) {
+                size_t bodyBegin;
+                const table_cl message = getMessage(b, bodyBegin, /*DictionaryBatch*/ 2);
+                const table_cl dictBatch = message.table(2);
+                if (dictBatch.get<int64_t>(0, 0) != id)
+                    continue;
+                if (!dictBatch.get<uint8_t>(2, 0))
+                    r.clear();  // (not a delta: replaces)
+                const table_cl batch = dictBatch.table(1);
+                checkUncompressed(batch);
+                appendStrings(batch, 0, 0, bodyBegin, large, r);
+            }
+            return r;
+        }
+        forEachBatch(ixField, [&](const table_cl &batch, size_t ixNode, size_t ixBuffer, size_t bodyBegin) {
+            appendStrings(batch, ixNode, ixBuffer, bodyBegin, large, r);
+        });
+        return r;
+    }
+
+   protected:
+    // Type union (Schema.fbs)
+    static const uint8_t typeNull = 1;
+    static const uint8_t typeInt = 2;
+    static const uint8_t typeFloatingPoint = 3;
+    static const uint8_t typeBinary = 4;
+    static const uint8_t typeUtf8 = 5;
+    static const uint8_t typeBool = 6;
+    static const uint8_t typeDate = 8;
+    static const uint8_t typeTime = 9;
+    static const uint8_t typeTimestamp = 10;
+    static const uint8_t typeStruct = 13;
+    static const uint8_t typeUnion = 14;
+    static const uint8_t typeFixedSizeList = 16;
+    static const uint8_t typeDuration = 18;
+    static const uint8_t typeLargeBinary = 19;
+    static const uint8_t typeLargeUtf8 = 20;
+    static const uint8_t typeBinaryView = 23;
+    static const uint8_t typeRunEndEncoded = 22;
+    static const uint8_t typeUtf8View = 24;
+    static const uint8_t typeListView = 25;
+    static const uint8_t typeLargeListView = 26;
+
+    // read access to a flatbuffers table in the file (little endian host)
+    class table_cl {
+       public:
+        table_cl() {}
+        table_cl(const arrowFile_cl *pFile, size_t pos) : pFile(pFile), pos(pos) {
+            vtable = pos - (int64_t)pFile->get<int32_t>(pos);
+            vtableSize = pFile->get<uint16_t>(vtable);
+        }
+        bool valid() const {
+            return pFile != NULL;
+        }
+        // scalar field ix (def: if absent)
+        template <typename T>
+        T get(int ix, T def) const {
+            const size_t p = fieldPos(ix);
+            return p ? pFile->get<T>(p) : def;
+        }
+        // scalar at a position, e.g. in a struct (see vecElem)
+        template <typename T>
+        T at(size_t p) const {
+            return pFile->get<T>(p);
+        }
+        // table field ix (invalid if absent)
+        table_cl table(int ix) const {
+            const size_t p = ref(ix);
+            return p ? table_cl(pFile, p) : table_cl();
+        }
+        // length of vector field ix (0 if absent)
+        size_t vecLen(int ix) const {
+            const size_t p = ref(ix);
+            return p ? pFile->get<uint32_t>(p) : 0;
+        }
+        // position of struct element ixElem of vector field ix
+        size_t vecElem(int ix, size_t ixElem, size_t elemSize) const {
+            if (ixElem >= vecLen(ix))
+                pFile->invalid();
+            return ref(ix) + 4 + ixElem * elemSize;
+        }
+        // table element ixElem of vector field ix
+        table_cl vecTable(int ix, size_t ixElem) const {
+            const size_t p = vecElem(ix, ixElem, 4);
+            return table_cl(pFile, p + pFile->get<uint32_t>(p));
+        }
+        string str(int ix) const {
+            const size_t p = ref(ix);
+            if (!p)
+                return "";
+            const size_t len = pFile->get<uint32_t>(p);
+            pFile->check(p + 4, len);
+            return string(pFile->f.data() + p + 4, len);
+        }
+
+       protected:
+        // position of field ix (0: absent)
+        size_t fieldPos(int ix) const {
+            const size_t o = 4 + 2 * ix;
+            if (o + 2 > vtableSize)
+                return 0;
+            const size_t offset = pFile->get<uint16_t>(vtable + o);
+            return offset ? pos + offset : 0;
+        }
+        // position referenced by offset field ix (table, vector, string. 0: absent)
+        size_t ref(int ix) const {
+            const size_t p = fieldPos(ix);
+            return p ? p + pFile->get<uint32_t>(p) : 0;
+        }
+        const arrowFile_cl *pFile = NULL;
+        size_t pos = 0;
+        size_t vtable = 0;
+        size_t vtableSize = 0;
+    };
+
+    // location of a message (Footer.fbs)
+    struct block_t {
+        int64_t offset;
+        int32_t metaDataLength;
+        int64_t bodyLength;
+    };
+
+    string filename;
+    aCCb::mappedFile f;
+    table_cl schema;
+    vector<block_t> recordBatches;
+    vector<block_t> dictionaryBatches;
+
+    [[noreturn]] void invalid() const {
+        throw aCCb::argObjException("invalid Arrow IPC file: " + filename);
+    }
+
+    void check(size_t pos, size_t len) const {
+        if ((pos > f.size()) || (len > f.size() - pos))
+            invalid();
+    }
+
+    template <typename T>
+    T get(size_t pos) const {
+        check(pos, sizeof(T));
+        T v;
+        memcpy(&v, f.data() + pos, sizeof(T));
+        return v;
+    }
+
+    table_cl getRoot(size_t pos) const {
+        return table_cl(this, pos + get<uint32_t>(pos));
+    }
+
+    block_t getBlock(const table_cl &footer, int ix, size_t ixElem) const {
+        const size_t p = footer.vecElem(ix, ixElem, 24);
+        return {get<int64_t>(p), get<int32_t>(p + 8), get<int64_t>(p + 16)};
+    }
+
+    // header of the message at b (checked for type headerType), bodyBegin: position of its body
+    table_cl getMessage(const block_t &b, size_t &bodyBegin, uint8_t headerType) const {
+        // (0xFFFFFFFF continuation marker, then metadata length. Without: legacy format)
+        const size_t fbBegin = b.offset + ((get<uint32_t>(b.offset) == 0xFFFFFFFF) ? 8 : 4);
+        bodyBegin = b.offset + b.metaDataLength;
+        check(bodyBegin, b.bodyLength);
+        const table_cl message = getRoot(fbBegin);
+        if (message.get<uint8_t>(1, 0) != headerType)
+            invalid();
+        return message;
+    }
+
+    static void checkUncompressed(const table_cl &batch) {
+        if (batch.table(3).valid())
+            throw aCCb::argObjException("compressed Arrow IPC file is not supported (write with compression='uncompressed')");
+    }
+
+    size_t getFieldIndex(const string &column) const {
+        const size_t nFields = schema.vecLen(1);
+        for (size_t ix = 0; ix < nFields; ++ix)
+            if (schema.vecTable(1, ix).str(0) == column)
+                return ix;
+        size_t ix;
+        if ((column.find_first_not_of("0123456789") != string::npos) || !aCCb::str2num(column, ix) || (ix >= nFields))
+            throw aCCb::argObjException("Arrow column not found: " + filename + ":" + column);
+        return ix;
+    }
+
+    // calls fn(batch, ixNode, ixBuffer, bodyBegin) for top-level field ixField in each record batch, with its first field node and buffer
+    template <typename fn_t>
+    void forEachBatch(size_t ixField, fn_t fn) const {
+        for (const block_t &b : recordBatches) {
+            size_t bodyBegin;
+            const table_cl message = getMessage(b, bodyBegin, /*RecordBatch*/ 3);
+            const table_cl batch = message.table(2);
+            checkUncompressed(batch);
+            // === skip the preceding fields (depth-first, one node per field) ===
+            size_t ixNode = 0;
+            size_t ixBuffer = 0;
+            size_t ixVariadic = 0;
+            for (size_t ix = 0; ix < ixField; ++ix)
+                skipField(schema.vecTable(1, ix), batch, ixNode, ixBuffer, ixVariadic);
+            fn(batch, ixNode, ixBuffer, bodyBegin);
+        }
+    }
+
+    // advances node and buffer index over a field and its children
+    void skipField(const table_cl &field, const table_cl &batch, size_t &ixNode, size_t &ixBuffer, size_t &ixVariadic) const {
+        ++ixNode;
+        const uint8_t typeType = field.get<uint8_t>(2, 0);
+        if (field.table(4).valid())
+            ixBuffer += 2;  // dictionary indices
+        else if ((typeType == typeBinary) || (typeType == typeUtf8) || (typeType == typeLargeBinary) || (typeType == typeLargeUtf8) || (typeType == typeListView) || (typeType == typeLargeListView))
+            ixBuffer += 3;  // (also list views)
+        else if ((typeType == typeBinaryView) || (typeType == typeUtf8View))
+            ixBuffer += 2 + batch.at<int64_t>(batch.vecElem(4, ixVariadic++, 8));
+        else if (typeType == typeUnion)
+            ixBuffer += (field.table(3).get<int16_t>(0, 0) == 0) ? 1 : 2;  // (sparse: type ids, dense: also offsets)
+        else if ((typeType == typeStruct) || (typeType == typeFixedSizeList))
+            ixBuffer += 1;  // (validity)
+        else if ((typeType != typeNull) && (typeType != typeRunEndEncoded))
+            ixBuffer += 2;  // (null, run-end encoded: none)
+        for (size_t ix = 0; ix < field.vecLen(5); ++ix)
+            skipField(field.vecTable(5, ix), batch, ixNode, ixBuffer, ixVariadic);
+    }
+
+    // data of buffer ixBuffer of a record batch, checked for at least minLen bytes
+    const char *getBuffer(const table_cl &batch, size_t ixBuffer, size_t bodyBegin, size_t minLen) const {
+        const size_t p = batch.vecElem(2, ixBuffer, 16);
+        const int64_t offset = get<int64_t>(p);
+        const int64_t len = get<int64_t>(p + 8);
+        if ((offset < 0) || (len < (int64_t)minLen))
+            invalid();
+        check(bodyBegin + offset, len);
+        return f.data() + bodyBegin + offset;
+    }
+
+    // appends the strings of a (large) utf8 / binary array to r (null: empty)
+    void appendStrings(const table_cl &batch, size_t ixNode, size_t ixBuffer, size_t bodyBegin, bool large, vector<string> &r) const {
+        const size_t length = batch.get<int64_t>(0, 0);
+        const size_t nodePos = batch.vecElem(1, ixNode, 16);
+        const size_t nodeLength = batch.at<int64_t>(nodePos);
+        const int64_t nullCount = batch.at<int64_t>(nodePos + 8);
+        const size_t n = std::min(length, nodeLength);
+        const uint8_t *pValidity = (nullCount > 0) ? (const uint8_t *)getBuffer(batch, ixBuffer, bodyBegin, (n + 7) / 8) : NULL;
+        const size_t offsetSize = large ? 8 : 4;
+        const char *pOffsets = getBuffer(batch, ixBuffer + 1, bodyBegin, n ? (n + 1) * offsetSize : 0);
+        const char *pData = getBuffer(batch, ixBuffer + 2, bodyBegin, 0);
+        const uint64_t dataLen = get<int64_t>(batch.vecElem(2, ixBuffer + 2, 16) + 8);  // (checked by getBuffer)
+        for (size_t ix = 0; ix < n; ++ix) {
+            uint64_t o0;
+            uint64_t o1;
+            if (large) {
+                o0 = getFrom<int64_t>(pOffsets + 8 * ix);
+                o1 = getFrom<int64_t>(pOffsets + 8 * (ix + 1));
+            } else {
+                o0 = (uint32_t)getFrom<int32_t>(pOffsets + 4 * ix);
+                o1 = (uint32_t)getFrom<int32_t>(pOffsets + 4 * (ix + 1));
+            }
+            if ((pValidity && !(pValidity[ix / 8] & (1 << (ix % 8)))) || (o1 < o0) || (o1 > dataLen))
+                r.push_back("");
+            else
+                r.push_back(string(pData + o0, o1 - o0));
+        }
+    }
+
+    template <typename T>
+    static T getFrom(const char *p) {
+        T v;
+        memcpy(&v, p, sizeof(T));
+        return v;
+    }
+
+    static string getIntType(int bitWidth, bool isSigned) {
+        if ((bitWidth != 8) && (bitWidth != 16) && (bitWidth != 32) && (bitWidth != 64))
+            return "";
+        return (isSigned ? ".int" : ".uint") + std::to_string(bitWidth);
+    }
+
+    // bytes per element of a type from getNumeric
+    static size_t getTypeSize(const string &type) {
+        if ((type == ".float") || (type == ".int32") || (type == ".uint32"))
+            return 4;
+        if ((type == ".double") || (type == ".int64") || (type == ".uint64"))
+            return 8;
+        return ((type == ".int16") || (type == ".uint16")) ? 2 : 1;
+    }
+};
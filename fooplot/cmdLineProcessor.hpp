@@ -5,6 +5,7 @@
 #include <vector>
 #include <limits>
 #include <algorithm> // std::find
+#include <cstdint>
 
 #include "../aCCb/cmdLineParsing.hpp"
 #include "../aCCb/stringToNum.hpp"
@@ -22,10 +23,18 @@ struct annot2args {
 // ==============================================================================
 class trace : public aCCb::argObj {
    public:
-    trace() : argObj("-trace"), marker("gx1") {}
+    trace() : argObj("-trace"), marker("gx1"), colormap("viridis") {}
     bool acceptArg_stateUnset(const string &a) {
         if (std::find(switchArgs.cbegin(), switchArgs.cend(), a) != switchArgs.cend()) {
             // implement switches here
+            if (a == "-hide")
+                hide = true;
+            else if (a == "-density")
+                density = true;
+            else if (a == "-lines")
+                lines = true;
+            else if (a == "-reorder")
+                reorder = true;
         } else if (std::find(stateArgs.cbegin(), stateArgs.cend(), a) != stateArgs.cend()) {
             state = a;
         } else {
@@ -41,7 +50,17 @@ class trace : public aCCb::argObj {
             dataY = a;
         else if (state == "-marker")
             marker = a;
-        else if (state == "-horLineY") {
+        else if (state == "-colormap")
+            colormap = a;
+        else if (state == "-colorData")
+            colorData = a;
+        else if (state == "-colorRange") {
+            if (!aCCb::str2num(a, colorMin)) throw aoException(state + ": failed to parse number ('" + a + "')");
+            state = "-colorRange (max)";
+            return true;
+        } else if (state == "-colorRange (max)") {
+            if (!aCCb::str2num(a, colorMax)) throw aoException(state + ": failed to parse number ('" + a + "')");
+        } else if (state == "-horLineY") {
             float v;
             if (!aCCb::str2num(a, v)) throw aoException(state + ": failed to parse number ('" + a + "')");
             horLineY.push_back(v);
@@ -67,6 +86,12 @@ class trace : public aCCb::argObj {
             return true;
         } else if (state == "-mask (value)") {
             if (!aCCb::str2num(a, maskVal)) throw aoException(state + ": failed to parse number ('" + a + "')");
+        } else if (state == "-maskCategorical") {
+            maskCategoricalFile = a;
+            state = "-maskCategorical (palette)";
+            return true;
+        } else if (state == "-maskCategorical (palette)") {
+            maskCategoricalPalette = a;
         } else
             throw runtime_error("state implementation missing: " + state);
         state = "";
@@ -80,12 +105,22 @@ class trace : public aCCb::argObj {
     vector<float> vertLineX;
     string maskFile;
     uint16_t maskVal;
+    string maskCategoricalFile;
+    string maskCategoricalPalette;
     vector<annot2args> annotations;
+    bool hide = false;
+    bool density = false;
+    bool lines = false;
+    bool reorder = false;
+    string colormap;
+    string colorData;
+    float colorMin = std::numeric_limits<float>::quiet_NaN();
+    float colorMax = std::numeric_limits<float>::quiet_NaN();
 
    protected:
-    const vector<string>
-        stateArgs{"-dataX", "-dataY", "-marker", "-horLineY", "-vertLineX", "-annot", "-annot2", "-mask"};
-    const vector<string> switchArgs;
+    vector<string>
+        stateArgs{"-dataX", "-dataY", "-marker", "-horLineY", "-vertLineX", "-annot", "-annot2", "-mask", "-colormap", "-colorData", "-colorRange", "-maskCategorical"};
+    vector<string> switchArgs{"-hide", "-density", "-lines", "-reorder"};
 };
 
 // ==============================================================================
@@ -93,18 +128,33 @@ class trace : public aCCb::argObj {
 // ==============================================================================
 class fooplotCmdLineArgRoot : public aCCb::argObj {
    public:
-    fooplotCmdLineArgRoot() : argObj("cmdline root") {}
+    // atRunTime: arguments sent to a running instance (-control), which rejects those that apply only at start-up
+    fooplotCmdLineArgRoot(bool atRunTime = false) : argObj("cmdline root"), atRunTime(atRunTime) {}
     bool acceptArg_stateUnset(const string &a) {
         // first pass to children (they are younger)
         if (argObj::acceptArg_stateUnset(a))
             return true;
 
+        if (atRunTime && (std::find(runTimeArgs.cbegin(), runTimeArgs.cend(), a) == runTimeArgs.cend()) &&
+            ((std::find(switchArgs.cbegin(), switchArgs.cend(), a) != switchArgs.cend()) || (std::find(stateArgs.cbegin(), stateArgs.cend(), a) != stateArgs.cend())))
+            throw aoException("'" + a + "' applies only at start-up");
+
         // handle it ourselves
         if (std::find(switchArgs.cbegin(), switchArgs.cend(), a) != switchArgs.cend()) {
             // tokens without follow-up argument
             if (a == "-trace") {
                 traces.push_back(trace());  // note: container may not invalidate iterators on insertion e.g. DO NOT use vector
                 stack.push_back(&traces.back());
+            } else if (a == "-mmap") {
+                mmap = true;
+            } else if (a == "-compact") {
+                compact = true;
+            } else if (a == "-follow") {
+                follow = true;
+            } else if (a == "-reload") {
+                reload = true;
+            } else if (a == "-panCache") {
+                panCache = true;
             } else if (a == "-help") {
                 showUsage = true;
             } else
@@ -146,6 +196,16 @@ class fooplotCmdLineArgRoot : public aCCb::argObj {
             syncfile = a;
         } else if (state == "-persist") {
             persistfile = a;
+        } else if (state == "-cacheDir") {
+            cacheDir = a;
+        } else if (state == "-cacheMaxMB") {
+            if (!aCCb::str2num(a, cacheMaxMB)) throw aoException(state + ": failed to parse number ('" + a + "')");
+        } else if (state == "-control") {
+            controlSocket = a;
+        } else if (state == "-streamView") {
+            streamView = a;
+            if ((a != "all") && (a != "none") && (!aCCb::str2num(a, streamViewSpan) || !(streamViewSpan > 0)))
+                throw aoException(state + ": expecting all, none or a positive number ('" + a + "')");
         } else if (state == "-testcase") {
             if (!aCCb::str2num(a, testcase)) throw aoException(state + ": failed to parse number ('" + a + "')");
         } else
@@ -168,11 +228,26 @@ class fooplotCmdLineArgRoot : public aCCb::argObj {
     int fontsize = 13;
     string syncfile;
     string persistfile;
+    // Unix domain socket for commands (-control)
+    string controlSocket;
+    string cacheDir;
+    uint64_t cacheMaxMB = 4096;
+    // all, none or X span, see streamViewSpan
+    string streamView = "all";
+    double streamViewSpan = std::numeric_limits<double>::quiet_NaN();
     std::deque<trace> traces;
     bool showUsage = false;
+    bool mmap = false;
+    bool compact = false;
+    bool follow = false;
+    bool reload = false;
+    bool panCache = false;
     int testcase = -1;
 
    protected:
-    vector<string> stateArgs{"-title", "-xlabel", "-ylabel", "-xLimLow", "-xLimHigh", "-yLimLow", "-yLimHigh", "-sync", "-persist", "-windowX", "-windowY", "-windowW", "-windowH", "-fontsize", "-testcase"};
-    vector<string> switchArgs{"-trace", "-help"};
+    vector<string> stateArgs{"-title", "-xlabel", "-ylabel", "-xLimLow", "-xLimHigh", "-yLimLow", "-yLimHigh", "-sync", "-persist", "-windowX", "-windowY", "-windowW", "-windowH", "-fontsize", "-cacheDir", "-cacheMaxMB", "-streamView", "-control", "-testcase"};
+    vector<string> switchArgs{"-trace", "-mmap", "-compact", "-follow", "-reload", "-panCache", "-help"};
+    // see atRunTime
+    bool atRunTime;
+    vector<string> runTimeArgs{"-trace", "-title", "-xlabel", "-ylabel", "-xLimLow", "-xLimHigh", "-yLimLow", "-yLimHigh"};
 };
\ No newline at end of file
@@ -0,0 +1,337 @@
+#pragma once
+#include <algorithm>  // min, max
+#include <atomic>
+#include <cstdint>
+#include <cstring>  // memcpy, memmove
+#include <future>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef FOOPLOT_ZSTD
+#include <zstd.h>
+#endif
+#ifdef FOOPLOT_LZ4
+#include <lz4.h>
+#endif
+
+#include "../aCCb/mappedFile.hpp"
+#include "../aCCb/stringUtil.hpp"
+using std::string, std::vector, std::runtime_error;
+
+// loads compressed binary data files: .zst (Zstandard) and .lz4 (LZ4 frame format).
+// Independent parts are decompressed in parallel, straight into the destination buffer: zstd frames of known size (e.g. written by pzstd), LZ4 blocks (lz4 default, not -BD).
+// Support is compiled in with FOOPLOT_ZSTD / FOOPLOT_LZ4 (see makefile)
+class compressedFile_cl {
+   public:
+    static bool isCompressedExt(const string &ext) {
+        return aCCb::caseInsensitiveStringCompare(".zst", ext) || aCCb::caseInsensitiveStringCompare(".lz4", ext);
+    }
+
+    // decompressed contents of filename as elements of T
+    template <typename T>
+    static vector<T> load(const string &filename, const string &ext) {
+        aCCb::mappedFile f(filename);
+        progress_cl progress(filename, f.size());
+        vector<T> r;
+        size_t nBytes;
+        if (aCCb::caseInsensitiveStringCompare(".zst", ext))
+            nBytes = loadZstd(f.data(), f.size(), filename, r, progress);
+        else
+            nBytes = loadLz4(f.data(), f.size(), filename, r, progress);
+        progress.finish();
+        if (nBytes % sizeof(T) != 0)
+            throw runtime_error("binary file contains partial element: " + filename);
+        r.resize(nBytes / sizeof(T));
+        if (r.capacity() - r.size() > r.size() / 8)
+            r.shrink_to_fit();  // (copies: only for significant slack e.g. .lz4 of many frames, each reserved by maximum block size)
+        return r;
+    }
+
+   protected:
+    // decompression progress on stderr, for large files only. add() may be called from any thread
+    class progress_cl {
+       public:
+        progress_cl(const string &filename, size_t total) : filename(filename), total(total), enabled(total >= minTotal) {}
+        ~progress_cl() {
+            if (pctShown >= 0)
+                std::cerr << std::endl;
+        }
+        void finish() {
+            if (enabled)
+                std::cerr << ("\rdecompressing " + filename + " 100%") << std::endl;
+            pctShown = -1;
+        }
+        // nBytes of compressed input have been processed
+        void add(size_t nBytes) {
+            if (!enabled)
+                return;
+            const int pct = (int)(100 * (done += nBytes) / total);
+            int prev = pctShown;
+            while ((pct > prev) && !pctShown.compare_exchange_weak(prev, pct))
+                ;
+            if (pct > prev)
+                std::cerr << ("\rdecompressing " + filename + " " + std::to_string(pct) + "%") << std::flush;
+        }
+
+       protected:
+        static const size_t minTotal = 64 << 20;
+        const string filename;
+        const size_t total;
+        const bool enabled;
+        std::atomic<size_t> done{0};
+        std::atomic<int> pctShown{-1};
+    };
+
+    // independently decompressible part of the input
+    struct job_t {
+        // position and capacity in the destination (bytes)
+        size_t destOffset;
+        size_t destSize;
+        // zstd: compressed frame
+        const char *pSrc;
+        size_t srcSize;
+        // LZ4: position of the block headers. All blocks of a frame with linked blocks (decompressed in sequence), otherwise one block
+        vector<size_t> lz4Blocks;
+    };
+
+    // resizes r to hold at least nBytes
+    template <typename T>
+    static char *reserveBytes(vector<T> &r, size_t nBytes) {
+        r.resize((nBytes + sizeof(T) - 1) / sizeof(T));
+        return (char *)r.data();
+    }
+
+    // runs fn(ixJob) for all jobs in parallel, largest first
+    template <typename fn_t>
+    static void runJobs(vector<job_t> &jobs, fn_t fn) {
+        vector<size_t> order(jobs.size());
+        for (size_t ix = 0; ix < order.size(); ++ix)
+            order[ix] = ix;
+        std::sort(order.begin(), order.end(), [&jobs](size_t a, size_t b) { return jobs[a].destSize > jobs[b].destSize; });
+        std::atomic<size_t> next{0};
+        auto worker = [&]() {
+            for (size_t ix; (ix = next++) < order.size();)
+                fn(order[ix]);
+        };
+        const size_t nThreads = std::min((size_t)std::max(std::thread::hardware_concurrency(), 1u), jobs.size());
+        vector<std::future<void>> futs;
+        for (size_t ix = 1; ix < nThreads; ++ix)
+            futs.push_back(std::async(std::launch::async, worker));
+        worker();
+        for (std::future<void> &f : futs)
+            f.get();
+    }
+
+    static uint64_t get32(const char *p) {
+        return (uint8_t)p[0] | ((uint64_t)(uint8_t)p[1] << 8) | ((uint64_t)(uint8_t)p[2] << 16) | ((uint64_t)(uint8_t)p[3] << 24);
+    }
+
+    // decompresses a .zst file into r. Returns the number of bytes
+    template <typename T>
+    static size_t loadZstd(const char *p, size_t n, const string &filename, vector<T> &r, progress_cl &progress) {
+#ifndef FOOPLOT_ZSTD
+        throw runtime_error("built without .zst support (see FOOPLOT_ZSTD in makefile): " + filename);
+#else
+        // === frames ===
+        vector<job_t> jobs;
+        size_t total = 0;
+        bool sizesKnown = true;
+        for (size_t ix = 0; ix < n;) {
+            const size_t srcSize = ZSTD_findFrameCompressedSize(p + ix, n - ix);
+            if (ZSTD_isError(srcSize))
+                throw runtime_error("invalid .zst file: " + filename + " (" + ZSTD_getErrorName(srcSize) + ")");
+            const unsigned long long destSize = ZSTD_getFrameContentSize(p + ix, n - ix);
+            if (destSize == ZSTD_CONTENTSIZE_ERROR)
+                throw runtime_error("invalid .zst file: " + filename);
+            sizesKnown &= (destSize != ZSTD_CONTENTSIZE_UNKNOWN);
+            jobs.push_back({total, (size_t)destSize, p + ix, srcSize, {}});
+            total += (size_t)destSize;
+            ix += srcSize;
+        }
+
+        // === size unknown (compressed from a pipe): stream through a buffer, appending to the destination ===
+        if (!sizesKnown) {
+            ZSTD_DStream *s = ZSTD_createDStream();
+            ZSTD_inBuffer in{p, n, 0};
+            vector<T> buf(((size_t)1 << 20) / sizeof(T));
+            r.reserve(2 * n / sizeof(T));
+            // bytes of an incomplete element at the start of buf
+            size_t nPartial = 0;
+            size_t ret = 0;
+            bool full = false;
+            while ((in.pos < in.size) || full) {
+                ZSTD_outBuffer out{(char *)buf.data() + nPartial, buf.size() * sizeof(T) - nPartial, 0};
+                const size_t prevPos = in.pos;
+                ret = ZSTD_decompressStream(s, &out, &in);
+                if (ZSTD_isError(ret))
+                    break;
+                progress.add(in.pos - prevPos);
+                full = (out.pos == out.size);
+                const size_t nBytes = nPartial + out.pos;
+                r.insert(r.end(), buf.begin(), buf.begin() + nBytes / sizeof(T));
+                nPartial = nBytes % sizeof(T);
+                memmove((char *)buf.data(), (char *)buf.data() + nBytes - nPartial, nPartial);
+            }
+            ZSTD_freeDStream(s);
+            if (ZSTD_isError(ret) || (ret != 0))
+                throw runtime_error("invalid .zst file: " + filename + " (" + (ZSTD_isError(ret) ? ZSTD_getErrorName(ret) : "truncated") + ")");
+            return r.size() * sizeof(T) + nPartial;
+        }
+
+        // === frames in parallel, each into its own range of the destination ===
+        char *pDest = reserveBytes(r, total);
+        runJobs(jobs, [&](size_t ixJob) {
+            const job_t &j = jobs[ixJob];
+            const size_t ret = (j.srcSize > streamSlice) ? decompressZstdStream(j, pDest, progress) : decompressZstd(j, pDest, progress);
+            if (ZSTD_isError(ret) || (ret != j.destSize))
+                throw runtime_error("invalid .zst file: " + filename + (ZSTD_isError(ret) ? " (" + string(ZSTD_getErrorName(ret)) + ")" : ""));
+        });
+        return total;
+#endif
+    }
+
+#ifdef FOOPLOT_ZSTD
+    // compressed size above which a zstd frame is decompressed in slices, for progress (some 5 % slower)
+    static const size_t streamSlice = 16 << 20;
+
+    // decompresses frame j to its range of pDest in one call. Returns the number of bytes or an error code
+    static size_t decompressZstd(const job_t &j, char *pDest, progress_cl &progress) {
+        ZSTD_DCtx *c = ZSTD_createDCtx();
+        const size_t ret = ZSTD_decompressDCtx(c, pDest + j.destOffset, j.destSize, j.pSrc, j.srcSize);
+        ZSTD_freeDCtx(c);
+        progress.add(j.srcSize);
+        return ret;
+    }
+
+    // decompresses frame j to its range of pDest, streaming slices of the input. Returns the number of bytes or an error code
+    static size_t decompressZstdStream(const job_t &j, char *pDest, progress_cl &progress) {
+        ZSTD_DStream *s = ZSTD_createDStream();
+        ZSTD_outBuffer out{pDest + j.destOffset, j.destSize, 0};
+        for (size_t pos = 0; pos < j.srcSize;) {
+            ZSTD_inBuffer in{j.pSrc + pos, std::min(j.srcSize - pos, streamSlice), 0};
+            while (in.pos < in.size) {
+                const size_t prevIn = in.pos;
+                const size_t prevOut = out.pos;
+                const size_t ret = ZSTD_decompressStream(s, &out, &in);
+                if (ZSTD_isError(ret) || ((in.pos == prevIn) && (out.pos == prevOut))) {
+                    ZSTD_freeDStream(s);
+                    return ZSTD_isError(ret) ? ret : (size_t)-1;  // error, or destination full
+                }
+            }
+            pos += in.size;
+            progress.add(in.size);
+        }
+        ZSTD_freeDStream(s);
+        return out.pos;
+    }
+#endif
+
+    // decompresses a .lz4 file (frame format, possibly several frames) into r. Returns the number of bytes.
+    // Block and content checksums are not verified
+    template <typename T>
+    static size_t loadLz4(const char *p, size_t n, const string &filename, vector<T> &r, progress_cl &progress) {
+#ifndef FOOPLOT_LZ4
+        throw runtime_error("built without .lz4 support (see FOOPLOT_LZ4 in makefile): " + filename);
+#else
+        const string invalid = "invalid .lz4 file: " + filename;
+
+        // === frames and blocks. Destination range per job: maximum block size (compacted later) ===
+        vector<job_t> jobs;
+        size_t total = 0;
+        for (size_t ix = 0; ix < n;) {
+            if (ix + 4 > n)
+                throw runtime_error(invalid);
+            const uint64_t magic = get32(p + ix);
+            if ((magic & 0xFFFFFFF0) == 0x184D2A50) {
+                // skippable frame
+                if (ix + 8 > n)
+                    throw runtime_error(invalid);
+                ix += 8 + get32(p + ix + 4);
+                continue;
+            }
+            if ((magic != 0x184D2204) || (ix + 7 > n))
+                throw runtime_error(invalid + ((magic == 0x184C2102) ? " (legacy format is not supported)" : ""));
+            const uint8_t flg = p[ix + 4];
+            const uint8_t bd = p[ix + 5];
+            const bool independent = flg & 0x20;
+            const bool blockChecksum = flg & 0x10;
+            const bool contentSize = flg & 0x08;
+            const bool contentChecksum = flg & 0x04;
+            const int blockSizeId = (bd >> 4) & 7;
+            if (((flg >> 6) != 1) || (blockSizeId < 4))
+                throw runtime_error(invalid);
+            if (flg & 0x01)
+                throw runtime_error(invalid + " (dictionary is not supported)");
+            const size_t blockMax = (size_t)1 << (8 + 2 * blockSizeId);
+            ix += 4 + 2 + (contentSize ? 8 : 0) + 1;
+
+            job_t linked{total, 0, NULL, 0, {}};
+            while (true) {
+                if (ix + 4 > n)
+                    throw runtime_error(invalid);
+                const uint64_t blockSize = get32(p + ix);
+                ix += 4;
+                if (blockSize == 0)
+                    break;  // end mark
+                const size_t srcSize = blockSize & 0x7FFFFFFF;
+                const bool uncompressed = blockSize & 0x80000000;
+                if ((ix + srcSize > n) || (srcSize > blockMax))
+                    throw runtime_error(invalid);
+                const size_t destSize = uncompressed ? srcSize : blockMax;
+                if (independent)
+                    jobs.push_back({total, destSize, NULL, 0, {ix - 4}});
+                else {
+                    linked.lz4Blocks.push_back(ix - 4);
+                    linked.destSize += destSize;
+                }
+                total += destSize;
+                ix += srcSize + (blockChecksum ? 4 : 0);
+            }
+            if (!independent && linked.lz4Blocks.size())
+                jobs.push_back(linked);
+            ix += contentChecksum ? 4 : 0;
+        }
+
+        // === jobs in parallel ===
+        char *pDest = reserveBytes(r, total);
+        vector<size_t> nWritten(jobs.size());
+        runJobs(jobs, [&](size_t ixJob) {
+            const job_t &j = jobs[ixJob];
+            char *pBegin = pDest + j.destOffset;
+            char *pOut = pBegin;
+            for (size_t ixBlock : j.lz4Blocks) {
+                const uint64_t blockSize = get32(p + ixBlock);
+                const char *pSrc = p + ixBlock + 4;
+                const size_t srcSize = blockSize & 0x7FFFFFFF;
+                const size_t capacity = j.destSize - (pOut - pBegin);
+                int ret;
+                if (blockSize & 0x80000000) {
+                    memcpy(pOut, pSrc, srcSize);
+                    ret = (int)srcSize;
+                } else {
+                    // linked blocks: up to 64k of preceding output of the frame is the dictionary
+                    const size_t dictSize = std::min((size_t)(pOut - pBegin), (size_t)65536);
+                    ret = LZ4_decompress_safe_usingDict(pSrc, pOut, (int)srcSize, (int)std::min(capacity, (size_t)INT32_MAX), pOut - dictSize, (int)dictSize);
+                }
+                if (ret < 0)
+                    throw runtime_error(invalid);
+                pOut += ret;
+                progress.add(srcSize);
+            }
+            nWritten[ixJob] = pOut - pBegin;
+        });
+
+        // === compact: jobs that wrote less than their capacity leave gaps ===
+        size_t pos = 0;
+        for (size_t ixJob = 0; ixJob < jobs.size(); ++ixJob) {
+            if (pos != jobs[ixJob].destOffset)
+                memmove(pDest + pos, pDest + jobs[ixJob].destOffset, nWritten[ixJob]);
+            pos += nWritten[ixJob];
+        }
+        return pos;
+#endif
+    }
+};
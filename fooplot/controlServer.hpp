@@ -0,0 +1,259 @@
+#pragma once
+#include <FL/Fl.H>
+
+#include <cctype>  // isspace
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>  // strerror
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+using std::string, std::vector;
+
+// accepts commands on a Unix domain socket (-control): one per line, as arguments in the command line grammar (see split). Each line is answered by a line "ok" with an optional result, or "error: " and a message.
+// A background thread serves one connection at a time. Commands run in the FLTK main thread (via Fl::awake), the thread waits for the result
+class controlServer_cl {
+   public:
+    // runs a command (main thread), returns its result (may be empty). Failure: throws
+    typedef std::function<string(const vector<string> &args)> handler_t;
+
+    controlServer_cl(const string &socketPath, handler_t handler) : socketPath(socketPath), handler(handler) {
+#ifdef _WIN32
+        throw std::runtime_error("-control: not supported on Windows");
+#else
+        sockaddr_un addr = {};
+        addr.sun_family = AF_UNIX;
+        if (socketPath.size() >= sizeof(addr.sun_path))
+            throw std::runtime_error("-control: socket path too long: " + socketPath);
+        memcpy(addr.sun_path, socketPath.c_str(), socketPath.size() + 1);
+
+        // === a socket left behind by an earlier instance is replaced, one in use is not. Neither is any other file ===
+        struct stat st;
+        if ((lstat(socketPath.c_str(), &st) == 0) && !S_ISSOCK(st.st_mode))
+            throw std::runtime_error("-control: exists and is not a socket: " + socketPath);
+        const int probeFd = socket(AF_UNIX, SOCK_STREAM, 0);
+        const bool inUse = (probeFd >= 0) && (connect(probeFd, (const sockaddr *)&addr, sizeof(addr)) == 0);
+        if (probeFd >= 0)
+            close(probeFd);
+        if (inUse)
+            throw std::runtime_error("-control: socket is in use by another process: " + socketPath);
+        unlink(socketPath.c_str());
+
+        listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if ((listenFd < 0) || (bind(listenFd, (const sockaddr *)&addr, sizeof(addr)) != 0) || (listen(listenFd, 4) != 0)) {
+            const string msg = strerror(errno);
+            if (listenFd >= 0)
+                close(listenFd);
+            throw std::runtime_error("-control: failed to listen on " + socketPath + ": " + msg);
+        }
+        if (pipe(wakeFds) != 0) {
+            close(listenFd);
+            unlink(socketPath.c_str());
+            throw std::runtime_error("-control: pipe() failed");
+        }
+        Fl::lock();  // (first call: lets Fl::awake wake up the main loop)
+        thread = std::thread([this]() { run(); });
+#endif
+    }
+
+    controlServer_cl(const controlServer_cl &) = delete;
+    controlServer_cl &operator=(const controlServer_cl &) = delete;
+
+    // must be called while the main loop no longer runs (a pending command is dropped)
+    ~controlServer_cl() {
+#ifndef _WIN32
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            stopping = true;
+        }
+        cv.notify_all();
+        (void)!write(wakeFds[1], "x", 1);
+        thread.join();
+        close(wakeFds[0]);
+        close(wakeFds[1]);
+        close(listenFd);
+        unlink(socketPath.c_str());
+#endif
+    }
+
+    // splits a command line into arguments at whitespace. "..." quotes an argument that contains whitespace ("" within: a literal quote)
+    static vector<string> split(const string &line) {
+        vector<string> r;
+        size_t ix = 0;
+        while (true) {
+            while ((ix < line.size()) && isspace((unsigned char)line[ix]))
+                ++ix;
+            if (ix == line.size())
+                return r;
+            string arg;
+            bool quoted = false;
+            for (; ix < line.size(); ++ix) {
+                const char c = line[ix];
+                if (c == '"') {
+                    if (quoted && (ix + 1 < line.size()) && (line[ix + 1] == '"'))
+                        arg += line[++ix];
+                    else
+                        quoted = !quoted;
+                } else if (!quoted && isspace((unsigned char)c))
+                    break;
+                else
+                    arg += c;
+            }
+            if (quoted)
+                throw std::runtime_error("unterminated quote");
+            r.push_back(arg);
+        }
+    }
+
+   protected:
+    const string socketPath;
+    handler_t handler;
+    int listenFd = -1;
+    // written on shutdown, wakes up the thread
+    int wakeFds[2] = {-1, -1};
+    std::thread thread;
+    // protects the request being run, and stopping
+    std::mutex mtx;
+    std::condition_variable cv;
+    bool stopping = false;
+    // a client that doesn't take its reply within this time is dropped
+    static constexpr int sendTimeout_ms = 5000;
+
+    // one command, handed to the main thread
+    struct request_t {
+        controlServer_cl *server;
+        string line;
+        string reply;
+        bool done = false;
+    };
+
+#ifndef _WIN32
+    // waits until fd is ready for events (default: readable). Returns false on shutdown or timeout (timeout_ms < 0: none)
+    bool waitFor(int fd, short events = POLLIN, int timeout_ms = -1) {
+        pollfd fds[2] = {{fd, events, 0}, {wakeFds[0], POLLIN, 0}};
+        while (true) {
+            const int nReady = poll(fds, 2, timeout_ms);
+            if (nReady < 0) {
+                if (errno == EINTR)
+                    continue;
+                return false;
+            }
+            if ((nReady == 0) || fds[1].revents)
+                return false;
+            if (fds[0].revents)
+                return true;
+        }
+    }
+
+    // sends all of data to a non-blocking fd, waiting at most sendTimeout_ms for buffer space. Returns false on failure, timeout or shutdown
+    bool sendAll(int fd, const string &data) {
+#ifdef MSG_NOSIGNAL
+        const int flags = MSG_NOSIGNAL;  // (a closed connection gives an error, not SIGPIPE)
+#else
+        const int flags = 0;
+#endif
+        for (size_t ix = 0; ix < data.size();) {
+            const ssize_t nSent = send(fd, data.data() + ix, data.size() - ix, flags);
+            if (nSent > 0)
+                ix += nSent;
+            else if ((nSent < 0) && (errno == EINTR))
+                continue;
+            else if ((nSent < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK))) {
+                if (!waitFor(fd, POLLOUT, sendTimeout_ms))
+                    return false;
+            } else
+                return false;
+        }
+        return true;
+    }
+
+    // serves connections (background thread)
+    void run() {
+        while (waitFor(listenFd)) {
+            const int fd = accept(listenFd, NULL, NULL);
+            if (fd < 0)
+                continue;
+            // (non-blocking: a client that doesn't read its replies can't stall shutdown, see sendAll)
+            fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+#ifdef SO_NOSIGPIPE
+            const int one = 1;
+            setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+            serve(fd);
+            close(fd);
+        }
+    }
+
+    // runs the commands of one connection until it is closed
+    void serve(int fd) {
+        string buf;
+        while (waitFor(fd)) {
+            char in[4096];
+            const ssize_t nRead = read(fd, in, sizeof(in));
+            if ((nRead < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR)))
+                continue;
+            if (nRead <= 0)
+                return;
+            buf.append(in, nRead);
+            size_t ixEol;
+            while ((ixEol = buf.find('\n')) != string::npos) {
+                string line = buf.substr(0, ixEol);
+                buf.erase(0, ixEol + 1);
+                if (!line.empty() && (line.back() == '\r'))
+                    line.pop_back();
+                if (line.find_first_not_of(" \t") == string::npos)
+                    continue;
+                string reply;
+                if (!runInMainThread(line, reply))
+                    return;  // shutdown
+                if (!sendAll(fd, reply + '\n'))
+                    return;  // drops the client
+            }
+        }
+    }
+
+    // hands a command line to the main thread and waits for its reply. Returns false on shutdown
+    bool runInMainThread(const string &line, string &reply) {
+        request_t r;
+        r.server = this;
+        r.line = line;
+        if (Fl::awake(cb_requestWrapper, (void *)&r) != 0) {
+            reply = "error: busy";  // (the main thread's queue is full)
+            return true;
+        }
+        std::unique_lock<std::mutex> lock(mtx);
+        cv.wait(lock, [this, &r]() { return r.done || stopping; });
+        reply = r.reply;
+        return r.done;
+    }
+
+    // runs a command (main thread)
+    static void cb_requestWrapper(void *userdata) {
+        request_t *r = (request_t *)userdata;
+        string reply;
+        try {
+            const string result = r->server->handler(split(r->line));
+            reply = (result == "") ? "ok" : "ok " + result;
+        } catch (std::exception &e) {
+            reply = string("error: ") + e.what();
+        }
+        // (notifies under the lock: once done is seen, r is gone)
+        std::unique_lock<std::mutex> lock(r->server->mtx);
+        r->reply = reply;
+        r->done = true;
+        r->server->cv.notify_all();
+    }
+#endif
+};
@@ -0,0 +1,157 @@
+#pragma once
+#include <algorithm>  // sort
+#include <chrono>
+#include <cstdint>
+#include <cstdio>   // snprintf
+#include <cstring>  // memcpy
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include "../aCCb/mappedFile.hpp"
+using std::string, std::vector;
+
+// persistent cache of converted data (-cacheDir), e.g. .txt or .csv parsed to float.
+// One file per entry: short text header, then the raw data (aligned, mmap-able).
+// Entries are keyed by canonical data reference, target type, size and mtime of the source file.
+// Least recently used entries are deleted when the total size exceeds the limit.
+// The cache is optional: any failure is treated as a miss.
+class dataCache_cl {
+   public:
+    dataCache_cl(const string &dir, uint64_t maxBytes) : dir(dir), maxBytes(maxBytes) {
+        std::error_code ec;
+        std::filesystem::create_directories(dir, ec);
+        try {
+            evict();  // limit may have changed
+        } catch (std::exception &) {
+        }
+    }
+
+    // ref: canonical data reference (file or file.csv:column), sourceFile: file that ref reads from. Returns false on miss
+    template <typename T>
+    bool load(const string &ref, const string &sourceFile, vector<T> &data) {
+        try {
+            const string key = getKey<T>(ref, sourceFile);
+            const std::filesystem::path path = getPath(key);
+            if (!std::filesystem::exists(path))
+                return false;
+            {
+                aCCb::mappedFile f(path.string());
+                const string header = getHeader(key);
+                if ((f.size() < header.size()) || (memcmp(f.data(), header.data(), header.size()) != 0))
+                    return false;  // hash collision or foreign file
+                const size_t nBytes = f.size() - header.size();
+                if (nBytes % sizeof(T) != 0)
+                    return false;
+                data.resize(nBytes / sizeof(T));
+                if (nBytes)
+                    memcpy(data.data(), f.data() + header.size(), nBytes);
+            }
+            // === mark as recently used ===
+            std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now());
+            return true;
+        } catch (std::exception &) {
+            return false;
+        }
+    }
+
+    // writes an entry atomically (temporary file, then rename) and evicts old entries
+    template <typename T>
+    void store(const string &ref, const string &sourceFile, const vector<T> &data) {
+        std::filesystem::path tmpPath;
+        try {
+            const string key = getKey<T>(ref, sourceFile);
+            const std::filesystem::path path = getPath(key);
+            tmpPath = path;
+            tmpPath += ".tmp" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count());  // unique among concurrent writers
+            {
+                std::ofstream f(tmpPath, std::ios::binary);
+                const string header = getHeader(key);
+                f.write(header.data(), header.size());
+                f.write((const char *)data.data(), data.size() * sizeof(T));
+                if (!f)
+                    throw std::runtime_error("cache write failed");
+            }
+            std::filesystem::rename(tmpPath, path);
+            evict();
+        } catch (std::exception &) {
+            std::error_code ec;
+            std::filesystem::remove(tmpPath, ec);
+        }
+    }
+
+   protected:
+    // cache directory
+    string dir;
+    // total size limit
+    uint64_t maxBytes;
+    // file extension of entries
+    static constexpr const char *ext = ".fpcache";
+    // alignment of data in an entry file
+    static const size_t align = 64;
+
+    template <typename T>
+    static string getTypeName() {
+        if constexpr (std::is_same_v<T, float>)
+            return "float";
+        else if constexpr (std::is_same_v<T, uint16_t>)
+            return "uint16";
+        else if constexpr (std::is_same_v<T, uint32_t>)
+            return "uint32";
+        else
+            static_assert(sizeof(T) == 0, "unsupported cache data type");
+    }
+
+    template <typename T>
+    static string getKey(const string &ref, const string &sourceFile) {
+        const uint64_t size = std::filesystem::file_size(sourceFile);
+        const int64_t mtime = std::filesystem::last_write_time(sourceFile).time_since_epoch().count();
+        return ref + "|" + getTypeName<T>() + "|" + std::to_string(size) + "|" + std::to_string(mtime);
+    }
+
+    // header line with the full key (detects hash collisions), padded with newlines for data alignment
+    static string getHeader(const string &key) {
+        string r = "fooplot cache 1\n" + key + "\n";
+        r.append((align - r.size() % align) % align, '\n');
+        return r;
+    }
+
+    // entry file by FNV-1a hash of the key
+    std::filesystem::path getPath(const string &key) const {
+        uint64_t h = 0xcbf29ce484222325ull;
+        for (char c : key) {
+            h ^= (uint8_t)c;
+            h *= 0x100000001b3ull;
+        }
+        char buf[17];
+        snprintf(buf, sizeof(buf), "%016llx", (unsigned long long)h);
+        return std::filesystem::path(dir) / (string(buf) + ext);
+    }
+
+    // deletes least recently used entries until the total size is within the limit
+    void evict() {
+        struct entry_t {
+            std::filesystem::path path;
+            std::filesystem::file_time_type time;
+            uint64_t size;
+        };
+        vector<entry_t> entries;
+        uint64_t total = 0;
+        for (const auto &e : std::filesystem::directory_iterator(dir)) {
+            if (!e.is_regular_file() || (e.path().extension() != ext))
+                continue;
+            entries.push_back({e.path(), e.last_write_time(), e.file_size()});
+            total += e.file_size();
+        }
+        std::sort(entries.begin(), entries.end(), [](const entry_t &a, const entry_t &b) { return a.time < b.time; });
+        for (const entry_t &e : entries) {
+            if (total <= maxBytes)
+                break;
+            std::error_code ec;
+            if (std::filesystem::remove(e.path, ec))
+                total -= e.size;
+        }
+    }
+};
@@ -0,0 +1,118 @@
+#pragma once
+#include <filesystem>
+#include <map>
+#include <set>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+using std::string, std::vector;
+
+// notices when files are written or replaced (e.g. by rename). Linux: inotify on their directories, getFd() becomes readable on a change.
+// Elsewhere, or for a file whose directory can't be watched, getChanged() compares modification time and size and needs to be called periodically (see needsPolling)
+class fileWatch_cl {
+   public:
+    fileWatch_cl() {
+#ifdef __linux__
+        fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+#endif
+    }
+
+    fileWatch_cl(const fileWatch_cl &) = delete;
+    fileWatch_cl &operator=(const fileWatch_cl &) = delete;
+
+    ~fileWatch_cl() {
+#ifdef __linux__
+        if (fd >= 0)
+            close(fd);
+#endif
+    }
+
+    // starts watching filename (which may not exist yet). Returns its name as reported by getChanged
+    string add(const string &filename) {
+        const std::filesystem::path p = std::filesystem::weakly_canonical(std::filesystem::absolute(filename));
+        const string fn = p.string();
+        if (!stampByFile.insert({fn, getStamp(fn)}).second)
+            return fn;
+#ifdef __linux__
+        if (fd >= 0) {
+            // (the directory: a file that is replaced gets a new inode)
+            const string dir = p.parent_path().string();
+            const int wd = inotify_add_watch(fd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+            if (wd >= 0)
+                dirByWd[wd] = dir;
+            else
+                polledFiles.insert(fn);  // (e.g. watch limit reached)
+        }
+#endif
+        return fn;
+    }
+
+    // becomes readable when a file may have changed, see getChanged (-1: not supported, poll instead)
+    int getFd() const {
+        return fd;
+    }
+
+    // whether getChanged needs to be called periodically, as getFd does not notice all changes
+    bool needsPolling() const {
+        return (fd < 0) || !polledFiles.empty();
+    }
+
+    // watched files that were written or replaced since the last call
+    vector<string> getChanged() {
+        std::set<string> r;
+#ifdef __linux__
+        if (fd >= 0) {
+            alignas(inotify_event) char buf[4096];
+            ssize_t nRead;
+            while ((nRead = read(fd, buf, sizeof(buf))) > 0) {
+                for (const char *p = buf; p < buf + nRead;) {
+                    const inotify_event *ev = (const inotify_event *)p;
+                    p += sizeof(inotify_event) + ev->len;
+                    auto it = dirByWd.find(ev->wd);
+                    if ((ev->len == 0) || (it == dirByWd.end()))
+                        continue;
+                    const string fn = (std::filesystem::path(it->second) / ev->name).string();
+                    if (stampByFile.count(fn))
+                        r.insert(fn);
+                }
+            }
+        }
+#endif
+        for (auto &[fn, stamp] : stampByFile) {
+            if ((fd >= 0) && !polledFiles.count(fn))
+                continue;
+            const stamp_t s = getStamp(fn);
+            if (s != stamp)
+                r.insert(fn);
+            stamp = s;
+        }
+        return vector<string>(r.begin(), r.end());
+    }
+
+   protected:
+    // inotify instance (-1: polling)
+    int fd = -1;
+    // modification time and size (polling). A missing file has neither
+    typedef std::pair<std::filesystem::file_time_type, uintmax_t> stamp_t;
+    // by watched file
+    std::map<string, stamp_t> stampByFile;
+    // watched directory by inotify watch descriptor
+    std::map<int, string> dirByWd;
+    // watched files polled despite inotify, as their directory could not be watched
+    std::set<string> polledFiles;
+
+    static stamp_t getStamp(const string &fn) {
+        std::error_code ec;
+        stamp_t r;
+        r.first = std::filesystem::last_write_time(fn, ec);
+        r.second = std::filesystem::file_size(fn, ec);
+        if (ec)
+            r = stamp_t();
+        return r;
+    }
+};
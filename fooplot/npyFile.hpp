@@ -0,0 +1,203 @@
+#pragma once
+#include <cstdint>
+#include <cstring>  // memcmp
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../aCCb/cmdLineParsing.hpp"
+#include "../aCCb/mappedFile.hpp"
+using std::string, std::vector;
+
+// locates the array in a NumPy .npy file, or in a member of an uncompressed .npz archive (np.savez), for memory-mapped access.
+// Only the headers are parsed; the payload is used in place.
+class npyFile_cl {
+   public:
+    // array layout
+    struct array_t {
+        // byte position of element 0 in the file
+        size_t dataOffset = 0;
+        // element type as binary file extension e.g. ".float"
+        string type;
+        size_t elemSize = 0;
+        bool bigEndian = false;
+        // dimensions (empty: scalar)
+        vector<size_t> shape;
+        // column-major 2D data
+        bool fortranOrder = false;
+    };
+
+    // array of a .npy file (member empty) or of member (name without .npy) of a .npz file
+    static array_t locate(const aCCb::mappedFile &f, const string &filename, const string &member) {
+        if (member == "")
+            return parseNpy(f.data(), f.size(), 0, filename);
+        size_t offset;
+        size_t size;
+        findZipMember(f, filename, member, offset, size);
+        return parseNpy(f.data() + offset, size, offset, filename + ":" + member);
+    }
+
+   protected:
+    static uint64_t get16(const char *p) {
+        return (uint8_t)p[0] | ((uint64_t)(uint8_t)p[1] << 8);
+    }
+    static uint64_t get32(const char *p) {
+        return get16(p) | (get16(p + 2) << 16);
+    }
+    static uint64_t get64(const char *p) {
+        return get32(p) | (get32(p + 4) << 32);
+    }
+
+    // parses the header of .npy data at p (offset: position of p in the file)
+    static array_t parseNpy(const char *p, size_t size, size_t offset, const string &name) {
+        // === magic, version, header length ===
+        if ((size < 10) || (memcmp(p, "\x93NUMPY", 6) != 0))
+            throw aCCb::argObjException("not a .npy array: " + name);
+        const int major = (uint8_t)p[6];
+        const size_t lenFieldSize = (major == 1) ? 2 : 4;
+        if ((major < 1) || (major > 3) || (size < 8 + lenFieldSize))
+            throw aCCb::argObjException("unsupported .npy version: " + name);
+        const size_t headerLen = (major == 1) ? get16(p + 8) : get32(p + 8);
+        const size_t headerBegin = 8 + lenFieldSize;
+        if (size < headerBegin + headerLen)
+            throw aCCb::argObjException("truncated .npy header: " + name);
+        const string header(p + headerBegin, headerLen);
+
+        array_t r;
+        r.dataOffset = offset + headerBegin + headerLen;
+
+        // === dtype e.g. '<f4' ===
+        const string descr = getValue(header, "descr", name);
+        if ((descr.size() != 5) || ((descr[0] != '\'') && (descr[0] != '"')))
+            throw aCCb::argObjException("unsupported .npy dtype " + descr + ": " + name);
+        const char byteOrder = descr[1];
+        const char kind = descr[2];
+        r.elemSize = descr[3] - '0';
+        r.bigEndian = (byteOrder == '>');
+        const bool isIntSize = (r.elemSize == 1) || (r.elemSize == 2) || (r.elemSize == 4) || (r.elemSize == 8);
+        if (kind == 'f')
+            r.type = (r.elemSize == 4) ? ".float" : (r.elemSize == 8) ? ".double" : "";
+        else if (((kind == 'i') || (kind == 'u')) && isIntSize)
+            r.type = string((kind == 'i') ? ".int" : ".uint") + std::to_string(r.elemSize * 8);
+        else if ((kind == 'b') && (r.elemSize == 1))
+            r.type = ".uint8";
+        if ((r.type == "") || ((byteOrder != '<') && (byteOrder != '>') && (byteOrder != '|') && (byteOrder != '=')))
+            throw aCCb::argObjException("unsupported .npy dtype " + descr + " (expecting float, double or integer): " + name);
+
+        // === layout ===
+        r.fortranOrder = (getValue(header, "fortran_order", name).substr(0, 4) == "True");
+        const string shape = getValue(header, "shape", name);
+        const size_t maxSize = std::numeric_limits<size_t>::max();
+        size_t nElem = 1;
+        for (size_t ix = 0; ix < shape.size();) {
+            if ((shape[ix] < '0') || (shape[ix] > '9')) {
+                ++ix;
+                continue;
+            }
+            size_t dim = 0;
+            for (; (ix < shape.size()) && (shape[ix] >= '0') && (shape[ix] <= '9'); ++ix) {
+                if (dim > (maxSize - 9) / 10)
+                    throw aCCb::argObjException("invalid .npy shape " + shape + ": " + name);
+                dim = dim * 10 + (shape[ix] - '0');
+            }
+            r.shape.push_back(dim);
+            if ((dim != 0) && (nElem > maxSize / dim))
+                throw aCCb::argObjException("invalid .npy shape " + shape + ": " + name);
+            nElem *= dim;
+        }
+        // (as division: nElem * elemSize may overflow)
+        if (nElem > (size - (r.dataOffset - offset)) / r.elemSize)
+            throw aCCb::argObjException("truncated .npy data: " + name);
+        return r;
+    }
+
+    // value of key in the header dict as text, up to the end of the value (shape: up to the closing parenthesis)
+    static string getValue(const string &header, const string &key, const string &name) {
+        size_t ix = header.find("'" + key + "'");
+        if (ix == string::npos)
+            throw aCCb::argObjException(".npy header lacks '" + key + "': " + name);
+        ix = header.find(':', ix);
+        if (ix == string::npos)
+            throw aCCb::argObjException("invalid .npy header: " + name);
+        ix = header.find_first_not_of(' ', ix + 1);
+        if (ix == string::npos)
+            throw aCCb::argObjException("invalid .npy header: " + name);
+        const size_t ixEnd = (header[ix] == '(') ? header.find(')', ix) : header.find_first_of(",}", ix);
+        if (ixEnd == string::npos)
+            throw aCCb::argObjException("invalid .npy header: " + name);
+        return header.substr(ix, ixEnd - ix + ((header[ix] == '(') ? 1 : 0));
+    }
+
+    // data position and size of the array member (name without .npy) of an uncompressed zip archive, via the central directory (with ZIP64 extensions, as written by np.savez)
+    static void findZipMember(const aCCb::mappedFile &f, const string &filename, const string &member, size_t &offset, size_t &size) {
+        const char *p = f.data();
+        const size_t n = f.size();
+
+        // === end of central directory (followed by a comment of up to 64k) ===
+        size_t ixEocd = string::npos;
+        for (size_t ix = (n >= 22) ? n - 22 + 1 : 0; ix-- > 0 && (n - ix <= 22 + 65535);)
+            if (get32(p + ix) == 0x06054b50) {
+                ixEocd = ix;
+                break;
+            }
+        if (ixEocd == string::npos)
+            throw aCCb::argObjException("not a .npz (zip) archive: " + filename);
+        uint64_t nEntries = get16(p + ixEocd + 10);
+        uint64_t cdOffset = get32(p + ixEocd + 16);
+        if (((cdOffset == 0xFFFFFFFF) || (nEntries == 0xFFFF)) && (ixEocd >= 20) && (get32(p + ixEocd - 20) == 0x07064b50)) {
+            const uint64_t ixEocd64 = get64(p + ixEocd - 20 + 8);
+            if ((ixEocd64 + 56 > n) || (get32(p + ixEocd64) != 0x06064b50))
+                throw aCCb::argObjException("invalid .npz (zip) archive: " + filename);
+            nEntries = get64(p + ixEocd64 + 32);
+            cdOffset = get64(p + ixEocd64 + 48);
+        }
+
+        // === central directory entries ===
+        size_t ix = cdOffset;
+        for (uint64_t ixEntry = 0; ixEntry < nEntries; ++ixEntry) {
+            if ((ix + 46 > n) || (get32(p + ix) != 0x02014b50))
+                throw aCCb::argObjException("invalid .npz (zip) archive: " + filename);
+            const uint64_t method = get16(p + ix + 10);
+            uint64_t compSize = get32(p + ix + 20);
+            uint64_t uncompSize = get32(p + ix + 24);
+            const size_t nameLen = get16(p + ix + 28);
+            const size_t extraLen = get16(p + ix + 30);
+            const size_t commentLen = get16(p + ix + 32);
+            uint64_t localOffset = get32(p + ix + 42);
+            if (ix + 46 + nameLen + extraLen > n)
+                throw aCCb::argObjException("invalid .npz (zip) archive: " + filename);
+            const string name(p + ix + 46, nameLen);
+            if (name == member + ".npy") {
+                // === ZIP64 extra field: 64 bit values for the fields that are 0xFFFFFFFF, in this order ===
+                const size_t ixExtraEnd = ix + 46 + nameLen + extraLen;
+                for (size_t ixExtra = ix + 46 + nameLen; ixExtra + 4 <= ixExtraEnd;) {
+                    const uint64_t id = get16(p + ixExtra);
+                    const size_t len = get16(p + ixExtra + 2);
+                    if (ixExtra + 4 + len > ixExtraEnd)
+                        throw aCCb::argObjException("invalid .npz (zip) archive: " + filename);
+                    if (id == 0x0001) {
+                        const char *pVal = p + ixExtra + 4;
+                        for (uint64_t *v : {&uncompSize, &compSize, &localOffset})
+                            if ((*v == 0xFFFFFFFF) && (pVal + 8 <= p + ixExtra + 4 + len)) {
+                                *v = get64(pVal);
+                                pVal += 8;
+                            }
+                    }
+                    ixExtra += 4 + len;
+                }
+                if (method != 0)
+                    throw aCCb::argObjException("compressed .npz member is not supported (write with np.savez, not np.savez_compressed): " + filename + ":" + member);
+                if ((localOffset + 30 > n) || (get32(p + localOffset) != 0x04034b50))
+                    throw aCCb::argObjException("invalid .npz (zip) archive: " + filename);
+                offset = localOffset + 30 + get16(p + localOffset + 26) + get16(p + localOffset + 28);
+                size = uncompSize;
+                if (offset + size > n)
+                    throw aCCb::argObjException("truncated .npz archive: " + filename);
+                return;
+            }
+            ix += 46 + nameLen + extraLen + commentLen;
+        }
+        throw aCCb::argObjException(".npz member not found: " + filename + ":" + member);
+    }
+};
@@ -0,0 +1,67 @@
+#pragma once
+#include <cstdint>
+#include <cstring>  // memcpy
+#include <string>
+#include <type_traits>
+
+#include "../aCCb/stringUtil.hpp"
+using std::string;
+
+// unpacks ADC samples of 10 or 12 bits, packed without gaps (.packed10: 4 samples in 5 bytes, .packed12: 2 samples in 3 bytes).
+// Bit order "little": sample 0 is in the low bits of byte 0 (little endian bit stream). "big": sample 0 is in the high bits of byte 0.
+// Four samples at a time from one unaligned 64 bit load, shifted and masked in registers (no shuffle instructions needed beyond the SSE2 baseline)
+class packedSamples_cl {
+   public:
+    // bits per sample for a file extension, 0 if not packed
+    static int getBits(const string &ext) {
+        if (aCCb::caseInsensitiveStringCompare(".packed10", ext))
+            return 10;
+        if (aCCb::caseInsensitiveStringCompare(".packed12", ext))
+            return 12;
+        return 0;
+    }
+
+    // number of complete samples in nBytes
+    static size_t getCount(size_t nBytes, int bits) {
+        return nBytes * 8 / bits;
+    }
+
+    // unpacks samples ixBegin (multiple of 4) to ixEnd - 1 from the packed data p of nBytes to pDest[ixBegin...]. T: int16_t (two's complement) or uint16_t
+    template <typename T>
+    static void unpack(const char *p, size_t nBytes, int bits, bool bigEndian, size_t ixBegin, size_t ixEnd, T *pDest) {
+        if (bits == 10)
+            bigEndian ? unpack<T, 10, true>(p, nBytes, ixBegin, ixEnd, pDest) : unpack<T, 10, false>(p, nBytes, ixBegin, ixEnd, pDest);
+        else
+            bigEndian ? unpack<T, 12, true>(p, nBytes, ixBegin, ixEnd, pDest) : unpack<T, 12, false>(p, nBytes, ixBegin, ixEnd, pDest);
+    }
+
+   protected:
+    template <typename T, int bits, bool bigEndian>
+    static void unpack(const char *p, size_t nBytes, size_t ixBegin, size_t ixEnd, T *pDest) {
+        // 4 samples per group of bits / 2 bytes
+        const size_t groupBytes = bits / 2;
+        const uint64_t mask = (1u << bits) - 1;
+        for (size_t ix = ixBegin; ix < ixEnd; ix += 4) {
+            const size_t offset = ix / 4 * groupBytes;
+            uint64_t w = 0;
+            if (offset + 8 <= nBytes)
+                memcpy(&w, p + offset, 8);
+            else
+                memcpy(&w, p + offset, nBytes - offset);  // last group(s): zero padded
+            if constexpr (bigEndian)
+                w = __builtin_bswap64(w);  // byte 0 is now the most significant
+            T s[4];
+            for (int j = 0; j < 4; ++j) {
+                const uint32_t v = (uint32_t)((bigEndian ? (w >> (64 - bits * (j + 1))) : (w >> (bits * j))) & mask);
+                if constexpr (std::is_signed_v<T>)
+                    s[j] = (T)((int32_t)(v << (32 - bits)) >> (32 - bits));
+                else
+                    s[j] = (T)v;
+            }
+            if (ix + 4 <= ixEnd)
+                memcpy(pDest + ix, s, sizeof(s));
+            else
+                memcpy(pDest + ix, s, (ixEnd - ix) * sizeof(T));
+        }
+    }
+};
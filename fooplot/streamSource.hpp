@@ -0,0 +1,342 @@
+#pragma once
+#include <algorithm>  // min, max
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>  // memcpy
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <fcntl.h>  // _O_BINARY
+#include <io.h>     // _read, _setmode, _get_osfhandle
+#ifndef NOMINMAX
+#define NOMINMAX  // windows.h would otherwise break std::min, std::max
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+#include "../aCCb/plot2d/column.hpp"
+using std::string, std::vector;
+
+// data that arrives over time, read into a growing buffer: from stdin ("-") or a named pipe by a background thread, or the appended tail of a growing file (-follow) on poll().
+// The main thread takes snapshots (see getColumn) that share the buffer: the reader only writes behind them.
+// When the buffer is full, the data moves to a larger one. Older snapshots keep the previous buffer.
+// The reader thread waits for data interruptibly and is stopped and joined on destruction
+class streamSource_cl {
+   public:
+    // whether filename is read as a stream: "-" (stdin) or a named pipe
+    static bool isStream(const string &filename) {
+        if (filename == "-")
+            return true;
+        std::error_code ec;
+        return std::filesystem::is_fifo(filename, ec);
+    }
+
+    // starts reading filename: binary elements of type T, or text with one number per line (parseLine non-NULL, T float)
+    template <typename T>
+    static std::shared_ptr<streamSource_cl> open(const string &filename, float (*parseLine)(const char *pBegin, const char *pEnd) = NULL) {
+        auto r = std::make_shared<reader_cl<T>>(filename, parseLine, /*following*/ false);
+        r->start();
+        return r;
+    }
+
+    // reads the current contents of a regular file, as open(). Data appended later is read by poll(). A last line without newline is held back until it is complete
+    template <typename T>
+    static std::shared_ptr<streamSource_cl> follow(const string &filename, float (*parseLine)(const char *pBegin, const char *pEnd) = NULL) {
+        auto r = std::make_shared<reader_cl<T>>(filename, parseLine, /*following*/ true);
+        r->poll();
+        return r;
+    }
+
+    virtual ~streamSource_cl() {}
+
+    // number of elements that have arrived
+    virtual size_t size() const = 0;
+
+    // all elements that have arrived
+    virtual column_cl getColumn() = 0;
+
+    // followed file: reads what has been appended since the last call
+    virtual void poll() = 0;
+
+   protected:
+    template <typename T>
+    class reader_cl;
+};
+
+template <typename T>
+class streamSource_cl::reader_cl : public streamSource_cl {
+   public:
+    reader_cl(const string &filename, float (*parseLine)(const char *, const char *), bool following) : filename(filename), parseLine(parseLine), following(following) {
+        if (!following)
+            return;  // opened by the reader thread (a named pipe blocks until the writer opens it)
+        fd = openFile(filename);
+        if (fd < 0)
+            throw std::runtime_error("failed to open file: " + filename);
+        // === room for the current contents and some growth, read at once ===
+        std::error_code ec;
+        const size_t nElem = std::filesystem::file_size(filename, ec) / sizeof(T);
+        if (!parseLine && !ec)
+            reserve(nElem + nElem / 4);
+    }
+
+    reader_cl(const reader_cl &) = delete;
+    reader_cl &operator=(const reader_cl &) = delete;
+
+    ~reader_cl() {
+        stop();
+        if (fd > 0)
+            closeFile(fd);
+#ifdef _WIN32
+        if (hThread)
+            CloseHandle(hThread);
+#else
+        for (int wakeFd : wakeFds)
+            if (wakeFd >= 0)
+                close(wakeFd);
+#endif
+    }
+
+    // starts the reader thread (see run)
+    void start() {
+#ifndef _WIN32
+        if (pipe(wakeFds) != 0)
+            throw std::runtime_error("pipe() failed");
+#endif
+        opened = (filename == "-");
+        thread = std::thread([this]() {
+#ifdef _WIN32
+            HANDLE h;
+            if (DuplicateHandle(GetCurrentProcess(), GetCurrentThread(), GetCurrentProcess(), &h, 0, FALSE, DUPLICATE_SAME_ACCESS))
+                hThread = h;
+#endif
+            run();
+            finished = true;
+        });
+    }
+
+    size_t size() const {
+        return n;
+    }
+
+    column_cl getColumn() {
+        std::unique_lock<std::mutex> lock(mtx);
+        return column_cl((const T *)buf.get(), n, buf);
+    }
+
+    // reads until end of stream or stop (background thread)
+    void run() {
+        fd = (filename == "-") ? 0 : openFile(filename);
+        opened = true;
+        if (stopping)
+            return;
+        if (fd < 0) {
+            std::cerr << "failed to open stream: " << filename << std::endl;
+            return;
+        }
+#ifdef _WIN32
+        if (fd == 0)
+            _setmode(0, _O_BINARY);
+#endif
+        while (readSome()) {
+        }
+        if (stopping)
+            return;
+        if (parseLine && (partial.find_first_not_of(" \t\r") != string::npos)) {
+            const T v = (T)parseLine(partial.data(), partial.data() + partial.size());  // last line without newline
+            append(&v, 1);
+        }
+    }
+
+    void poll() {
+        if (following)
+            while (readSome()) {
+            }
+    }
+
+   protected:
+    // min. free space for a read (bytes, also elements of the first buffer)
+    static const size_t readSize = 1 << 16;
+    const string filename;
+    float (*parseLine)(const char *, const char *);
+    const bool following;
+    int fd = -1;
+    // elements 0..n-1 are valid (written by the reader only). Not initialized beyond
+    std::shared_ptr<T> buf;
+    size_t capacity = 0;
+    std::atomic<size_t> n{0};
+    // binary: bytes in buf, including a partial element
+    size_t nBytes = 0;
+    // text: bytes of an incomplete line
+    string partial;
+    // protects the exchange of buf
+    std::mutex mtx;
+    // reader thread (see start), asked to end by stopping
+    std::thread thread;
+    std::atomic<bool> stopping{false};
+    // the reader thread has returned from opening the file (a named pipe: once a writer opens it)
+    std::atomic<bool> opened{false};
+    // run() has returned
+    std::atomic<bool> finished{false};
+#ifdef _WIN32
+    // the reader thread, for cancelling its read (see stop)
+    std::atomic<HANDLE> hThread{NULL};
+#else
+    // written by stop, wakes up the reader thread
+    int wakeFds[2] = {-1, -1};
+#endif
+
+    // ends the reader thread
+    void stop() {
+        if (!thread.joinable())
+            return;
+        stopping = true;
+#ifdef _WIN32
+        // === a read may still block (console: until a line is complete), so cancel it. Repeated: the thread may not be in the read yet ===
+        while (!finished) {
+            if (hThread)
+                CancelSynchronousIo(hThread);
+            Sleep(1);
+        }
+#else
+        (void)!write(wakeFds[1], "x", 1);
+        // === a named pipe without writer: open blocks until one opens it, so open it for writing ===
+        for (int nTries = 0; !opened; ++nTries) {
+            const int fdWrite = ::open(filename.c_str(), O_WRONLY | O_NONBLOCK);
+            if (fdWrite >= 0)
+                close(fdWrite);
+            if (nTries == 1000) {
+                thread.detach();  // (e.g. the pipe was removed. Unlikely, but don't hang on exit)
+                return;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+#endif
+        thread.join();
+    }
+
+    // waits until data can be read (or the end of data). Returns false on stop
+    bool waitForData() {
+        if (following)
+            return true;  // (a file: reads don't block)
+#ifdef _WIN32
+        // === pipe: poll for data. Console: wait for input events (a read may then still block until a line is complete, see stop) ===
+        const HANDLE h = (HANDLE)_get_osfhandle(fd);
+        const DWORD fileType = GetFileType(h);
+        while (!stopping) {
+            if (fileType == FILE_TYPE_PIPE) {
+                DWORD nAvail = 0;
+                if (!PeekNamedPipe(h, NULL, 0, NULL, &nAvail, NULL) || (nAvail > 0))
+                    return true;  // data, or the end of the pipe
+                Sleep(10);
+            } else if (fileType == FILE_TYPE_CHAR) {
+                if (WaitForSingleObject(h, 10) == WAIT_OBJECT_0)
+                    return true;
+            } else
+                return true;  // file
+        }
+        return false;
+#else
+        pollfd fds[2] = {{fd, POLLIN, 0}, {wakeFds[0], POLLIN, 0}};
+        while (true) {
+            if (::poll(fds, 2, -1) < 0) {
+                if (errno == EINTR)
+                    continue;
+                return true;  // (read reports the error)
+            }
+            if (fds[1].revents)
+                return false;
+            if (fds[0].revents)
+                return true;  // data, end of data or error
+        }
+#endif
+    }
+
+    // reads once (a pipe: waits for data). Returns false at the end of data or on stop
+    bool readSome() {
+        if (!waitForData())
+            return false;
+        if (parseLine) {
+            // === text: complete lines ===
+            char in[readSize];
+            const int nRead = readFile(fd, in, sizeof(in));
+            if (nRead <= 0)
+                return false;
+            partial.append(in, nRead);
+            vector<T> values;
+            size_t nUsed = 0;
+            for (size_t ixEol; (ixEol = partial.find('\n', nUsed)) != string::npos; nUsed = ixEol + 1)
+                values.push_back((T)parseLine(partial.data() + nUsed, partial.data() + ixEol));
+            partial.erase(0, nUsed);
+            append(values.data(), values.size());
+            return true;
+        }
+
+        // === binary: directly into the buffer (a partial element waits there for the rest) ===
+        if (capacity * sizeof(T) - nBytes < readSize)
+            reserve(2 * capacity);
+        const int nRead = readFile(fd, (char *)buf.get() + nBytes, capacity * sizeof(T) - nBytes);
+        if (nRead <= 0)
+            return false;
+        nBytes += nRead;
+        n = nBytes / sizeof(T);  // publish
+        return true;
+    }
+
+    // appends nValues elements
+    void append(const T *p, size_t nValues) {
+        if (n + nValues > capacity)
+            reserve(std::max(n + nValues, 2 * capacity));
+        memcpy(buf.get() + n, p, nValues * sizeof(T));
+        n = n + nValues;  // publish
+        nBytes = n * sizeof(T);
+    }
+
+    // moves the data to a buffer of at least nElem elements (snapshots keep the old one)
+    void reserve(size_t nElem) {
+        nElem = std::max(nElem, (size_t)readSize);
+        if (nElem <= capacity)
+            return;
+        std::shared_ptr<T> next(new T[nElem], std::default_delete<T[]>());
+        if (nBytes)
+            memcpy((void *)next.get(), (const void *)buf.get(), nBytes);
+        std::unique_lock<std::mutex> lock(mtx);
+        buf = next;
+        capacity = nElem;
+    }
+
+#ifdef _WIN32
+    static int openFile(const string &fn) {
+        return _open(fn.c_str(), _O_RDONLY | _O_BINARY);
+    }
+    static int readFile(int fd, char *p, size_t n) {
+        return _read(fd, p, (unsigned)std::min(n, (size_t)1 << 30));
+    }
+    static void closeFile(int fd) {
+        _close(fd);
+    }
+#else
+    static int openFile(const string &fn) {
+        return ::open(fn.c_str(), O_RDONLY);  // (a named pipe blocks until the writer opens it)
+    }
+    static int readFile(int fd, char *p, size_t n) {
+        return (int)::read(fd, p, std::min(n, (size_t)1 << 30));
+    }
+    static void closeFile(int fd) {
+        ::close(fd);
+    }
+#endif
+};
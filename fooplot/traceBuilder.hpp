@@ -0,0 +1,317 @@
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <set>
+#include <string>
+#include <utility>  // pair
+#include <vector>
+
+#include "../aCCb/cmdLineParsing.hpp"
+#include "../aCCb/plot2d/allDrawJobs.hpp"
+#include "../aCCb/plot2d/mortonOrder.hpp"
+#include "../aCCb/stringToNum.hpp"
+#include "../aCCb/stringUtil.hpp"
+#include "cmdLineProcessor.hpp"
+#include "markerMan.hpp"
+#include "traceMan.hpp"
+using std::string, std::vector;
+
+// creates the drawJobs of traces (-trace) from data in traceDataMan_cl.
+// A trace with data that grows (streamed or followed, see traceDataMan_cl::isGrowing) shows the points for which all its per-point data has arrived. Its drawJob is extended by update().
+// A trace with data from a rewritten file is rebuilt by reload()
+class traceBuilder_cl {
+   public:
+    traceBuilder_cl(traceDataMan_cl &traceDataMan, markerMan_cl &markerMan) : traceDataMan(traceDataMan), markerMan(markerMan) {}
+
+    // registers the data references of a trace with traceDataMan_cl (see announce there), before the first add
+    void announce(const trace &t) {
+        for (const string &ref : {t.dataX, t.dataY, t.maskFile, t.colorData, t.maskCategoricalFile})
+            traceDataMan.announce(ref);
+        for (const annot2args &aInput : t.annotations) {
+            traceDataMan.announce(aInput.mapFilename);
+            traceDataMan.announce(aInput.annotTxtFilename, /*asText*/ true);
+        }
+        // (-reorder: the reordered copy replaces the data in process memory. Point readout uses the mapped file)
+        if (t.reorder)
+            for (const string &ref : {t.dataX, t.dataY, t.maskFile, t.maskCategoricalFile})
+                traceDataMan.setMapped(ref);
+    }
+
+    // adds the drawJob of a trace. The traceBuilder_cl must outlive allDrawJobs (its drawJobs refer to data held here)
+    void add(const trace &t, allDrawJobs_cl &allDrawJobs) {
+        entries.emplace_back(t);
+        entry_t &e = entries.back();
+        e.growing = isGrowing(t);
+        e.ixJob = allDrawJobs.getNTraces();
+        try {
+            allDrawJobs.addDrawJob(build(e), /*visible*/ !t.hide);
+        } catch (...) {
+            entries.pop_back();  // (e.g. added at run time, see -control)
+            throw;
+        }
+        commit(e);
+        e.sourceFiles = getSourceFiles(e);
+    }
+
+    // replaces a trace (index base 0) e.g. at run time (-control). Data already loaded by traceDataMan_cl is reused. On failure, the trace is unchanged
+    void replace(size_t ixTrace, const trace &t, allDrawJobs_cl &allDrawJobs) {
+        if (ixTrace >= entries.size())
+            throw aCCb::argObjException("no trace " + std::to_string(ixTrace + 1));
+        entry_t &e = entries[ixTrace];
+        const trace prevArgs = e.args;
+        const bool prevGrowing = e.growing;
+        e.args = t;
+        e.growing = isGrowing(t);
+        try {
+            allDrawJobs.replaceDrawJob(e.ixJob, build(e));
+        } catch (...) {
+            e.args = prevArgs;
+            e.growing = prevGrowing;
+            throw;
+        }
+        commit(e);
+        e.slots[e.ixSlots ^ 1] = entry_t::slots_t();  // (the previous drawJob is gone: release its data)
+        e.sourceFiles = getSourceFiles(e);
+        allDrawJobs.setVisible(e.ixJob, !t.hide);
+    }
+
+    // removes a trace: it stays as an empty, hidden trace, so that the numbers of the others don't change
+    void remove(size_t ixTrace, allDrawJobs_cl &allDrawJobs) {
+        trace t;
+        t.hide = true;
+        replace(ixTrace, t, allDrawJobs);
+    }
+
+    size_t getNTraces() const {
+        return entries.size();
+    }
+
+    // extends the drawJobs of traces whose data has grown (after traceDataMan_cl::updateStreams) by the new points. Returns true if any has changed
+    bool update(allDrawJobs_cl &allDrawJobs) {
+        bool changed = false;
+        for (entry_t &e : entries) {
+            if (!e.growing || (getNPoints(e) == e.nPoints))
+                continue;
+            const data_t d = getData(e);
+            allDrawJobs.replaceDrawJob(e.ixJob, drawJob(allDrawJobs.getDrawJob(e.ixJob), d.dataX, d.dataY, d.mask, d.colorData, d.category), /*appended*/ true);
+            commit(e);
+            changed = true;
+        }
+        return changed;
+    }
+
+    // rebuilds the drawJobs of traces with data from the given files (after traceDataMan_cl::reload). A trace that fails keeps its drawJob. Returns true if any has changed
+    bool reload(const std::set<string> &sourceFiles, allDrawJobs_cl &allDrawJobs) {
+        bool changed = false;
+        for (entry_t &e : entries) {
+            bool uses = false;
+            for (const string &f : e.sourceFiles)
+                uses |= (sourceFiles.count(f) > 0);
+            if (!uses)
+                continue;
+            try {
+                allDrawJobs.replaceDrawJob(e.ixJob, build(e));
+                commit(e);
+                changed = true;
+            } catch (std::exception &ex) {
+                std::cerr << "reload: trace " << (e.ixJob + 1) << " keeps its previous data: " << ex.what() << std::endl;
+            }
+        }
+        return changed;
+    }
+
+   protected:
+    // one trace
+    struct entry_t {
+        entry_t(const trace &args) : args(args) {}
+        trace args;
+        // uses data that grows
+        bool growing = false;
+        // files of its data, see traceDataMan_cl::getSource (growing: none)
+        std::set<string> sourceFiles;
+        // index in allDrawJobs
+        size_t ixJob = 0;
+        // growing: number of points shown, and in the next set of slots
+        size_t nPoints = 0;
+        size_t nPointsNext = 0;
+        // per-point data of the drawJob (growing: cut to a common length), independent of later changes in traceDataMan_cl (see reload).
+        // Two sets, alternating: the drawJob being replaced may still be in use by a pan cache build
+        struct slots_t {
+            column_cl dataX;
+            column_cl dataY;
+            column_cl mask;
+            column_cl colorData;
+            column_cl category;
+            // trace data reordered for rendering (-reorder)
+            std::unique_ptr<mortonOrder_cl> reordered;
+        } slots[2];
+        // current set of slots (see commit)
+        int ixSlots = 0;
+    };
+
+    traceDataMan_cl &traceDataMan;
+    markerMan_cl &markerMan;
+    // (deque: drawJobs point into entries)
+    std::deque<entry_t> entries;
+
+    // whether a trace uses data that grows
+    bool isGrowing(const trace &t) const {
+        bool r = false;
+        for (const string &ref : {t.dataX, t.dataY, t.maskFile, t.colorData, t.maskCategoricalFile})
+            r |= traceDataMan.isGrowing(ref);
+        return r;
+    }
+
+    // files a trace depends on (see reload. Growing: none)
+    std::set<string> getSourceFiles(const entry_t &e) const {
+        std::set<string> r;
+        if (e.growing)
+            return r;
+        const trace &t = e.args;
+        vector<string> refs{t.dataX, t.dataY, t.maskFile, t.colorData, t.maskCategoricalFile};
+        for (const annot2args &a : t.annotations) {
+            refs.push_back(a.mapFilename);
+            refs.push_back(a.annotTxtFilename);
+        }
+        for (const string &ref : refs)
+            if (ref != "")
+                r.insert(traceDataMan.getSource(ref));
+        return r;
+    }
+
+    // number of points with all per-point data of a trace
+    size_t getNPoints(entry_t &e) {
+        const trace &t = e.args;
+        size_t n = std::numeric_limits<size_t>::max();
+        for (const column_cl *c : {traceDataMan.getColumn(t.dataX), traceDataMan.getColumn(t.dataY), traceDataMan.getColumn(t.maskFile), traceDataMan.getColumn(t.colorData), traceDataMan.getColumn(t.maskCategoricalFile)})
+            if (c)
+                n = std::min(n, c->size());
+        return n;
+    }
+
+    // per-point data of a trace (NULL: none)
+    struct data_t {
+        const column_cl *dataX;
+        const column_cl *dataY;
+        const column_cl *mask;
+        const column_cl *colorData;
+        const column_cl *category;
+        // where the data is held
+        entry_t::slots_t *slots;
+    };
+
+    // per-point data of a trace (growing: the points with all their data), in the next set of slots
+    data_t getData(entry_t &e) {
+        const trace &t = e.args;
+        entry_t::slots_t &s = e.slots[e.ixSlots ^ 1];
+        if (e.growing)
+            e.nPointsNext = getNPoints(e);
+        auto slot = [&e](const column_cl *c, column_cl &dest) -> const column_cl * {
+            if (!c)
+                return NULL;
+            dest = e.growing ? c->head(e.nPointsNext) : *c;
+            return &dest;
+        };
+        data_t r;
+        r.slots = &s;
+        r.dataX = slot(traceDataMan.getColumn(t.dataX), s.dataX);
+        r.dataY = slot(traceDataMan.getColumn(t.dataY), s.dataY);
+        r.colorData = slot(traceDataMan.getColumnAs<float>(t.colorData), s.colorData);
+        r.mask = slot(traceDataMan.getColumn(t.maskFile), s.mask);
+        r.category = slot(traceDataMan.getColumnAs<uint16_t>(t.maskCategoricalFile), s.category);
+        return r;
+    }
+
+    // makes the next set of slots current, once the drawJob that uses it has replaced the previous one
+    static void commit(entry_t &e) {
+        e.ixSlots ^= 1;
+        e.nPoints = e.nPointsNext;
+    }
+
+    // drawJob of a trace (growing: cut to the current common length of its data), see commit
+    drawJob build(entry_t &e) {
+        const trace &t = e.args;
+        const marker_cl *marker = markerMan.getMarker(t.marker);
+        if (!marker)
+            throw aCCb::argObjException("invalid marker description '" + t.marker + "'. Valid example: g.1");
+
+        vector<drawJob::annotation_cl> annotations;
+        for (const annot2args &aInput : t.annotations) {
+            const column_cl *pMapping = NULL;
+            if (aInput.mapFilename != "")
+                pMapping = traceDataMan.getColumn(aInput.mapFilename);
+            drawJob::annotation_cl aData(pMapping, traceDataMan.getAsciiVec(aInput.annotTxtFilename));
+            annotations.push_back(aData);
+        }
+
+        const colormap_cl *colormap = colormap_cl::get(t.colormap);
+        if (!colormap)
+            throw aCCb::argObjException("invalid colormap '" + t.colormap + "'. Valid: " + colormap_cl::getNames());
+
+        //* one trace */
+        const data_t d = getData(e);
+        const column_cl *dataX = d.dataX;
+        const column_cl *dataY = d.dataY;
+        if (dataX && !dataY)
+            throw aCCb::argObjException("-dataX without -dataY");
+        const column_cl *colorData = d.colorData;
+        if (colorData && !dataY)
+            throw aCCb::argObjException("-colorData without -dataY");
+        if ((colorData != NULL) + t.density + t.lines > 1)
+            throw aCCb::argObjException("-colorData, -density and -lines are exclusive");
+        drawJob::drawMode_e mode = t.density ? drawJob::DENSITY : colorData ? drawJob::COLORDATA : t.lines ? drawJob::LINES : drawJob::DOTS;
+        const column_cl *mask = d.mask;
+        // (checked here, not only when drawing: a reloaded file may have changed its length)
+        if (dataX && dataY && (dataX->size() != dataY->size()))
+            throw aCCb::argObjException("-dataX and -dataY differ in length");
+        if (mask && dataY && (mask->size() != dataY->size()))
+            throw aCCb::argObjException("-mask and -dataY differ in length");
+
+        drawJob j(
+            dataX,
+            dataY,
+            annotations,
+            marker,
+            t.vertLineX,
+            t.horLineY,
+            mask,
+            t.maskVal,
+            mode,
+            colormap,
+            colorData,
+            t.colorMin,
+            t.colorMax);
+
+        if (t.maskCategoricalFile != "") {
+            if (mode != drawJob::DOTS)
+                throw aCCb::argObjException("-maskCategorical can't be combined with -density, -colorData or -lines");
+            // === palette: comma-separated (value):(marker), by priority ===
+            vector<std::pair<uint16_t, const marker_cl *>> palette;
+            for (const string &entry : aCCb::split(t.maskCategoricalPalette, ',')) {
+                size_t ixColon = entry.find(':');
+                uint16_t value;
+                if ((ixColon == string::npos) || !aCCb::str2num(entry.substr(0, ixColon), value))
+                    throw aCCb::argObjException("-maskCategorical: invalid palette entry '" + entry + "'. Valid example: 0:gx1,1:r.2");
+                const marker_cl *m = markerMan.getMarker(entry.substr(ixColon + 1));
+                if (!m)
+                    throw aCCb::argObjException("-maskCategorical: invalid marker in palette entry '" + entry + "'. Valid example: g.1");
+                palette.push_back({value, m});
+            }
+            j.setCategorical(d.category, palette);
+        }
+
+        if (t.reorder && dataY) {
+            // (per-pixel color only, e.g. density counts per pixel. Plain dots don't gain from the copy, lines need the point order)
+            if (!j.hasPerPixelColor())
+                throw aCCb::argObjException("-reorder needs -density, -colorData or -maskCategorical");
+            if (e.growing)
+                throw aCCb::argObjException("-reorder can't be combined with streamed or followed data");
+            d.slots->reordered = std::make_unique<mortonOrder_cl>(dataX, *dataY, d.mask, traceDataMan.getColumn(t.maskCategoricalFile));
+            j.setReordered(d.slots->reordered.get());
+        }
+        return j;
+    }
+};
@@ -1,79 +1,104 @@
 #pragma once
-#include <cmath>  // HUGE_VALF
+#include <algorithm>  // min, max
+#include <atomic>
+#include <cctype>     // isspace
+#include <charconv>   // from_chars
+#include <cmath>      // HUGE_VALF
+#include <cstring>    // memchr, memcpy
+#include <exception>  // exception_ptr
 #include <filesystem>
 #include <fstream>
+#include <future>
+#include <limits>
 #include <map>
+#include <memory>
+#include <set>
 #include <stdexcept>
 #include <string>
+#include <thread>  // hardware_concurrency
+#include <type_traits>  // conditional_t
 
 #include "../aCCb/cmdLineParsing.hpp"
+#include "../aCCb/mappedFile.hpp"
+#include "../aCCb/plot2d/column.hpp"
+#include "../aCCb/stringToNum.hpp"
 #include "../aCCb/stringUtil.hpp"
+#include "arrowFile.hpp"
+#include "compressedFile.hpp"
+#include "dataCache.hpp"
+#include "npyFile.hpp"
+#include "packedSamples.hpp"
+#include "streamSource.hpp"
 
 using std::string, std::vector, std::map;
 
-// loads data files, converts format and keeps them in memory, providing const pointers via filename.
+// loads data files and keeps them in memory in their native element type, providing const pointers via filename.
 class traceDataMan_cl {
-    // converts vector of arbitrary type to float by casting
-    template <typename T>
-    static vector<float> floatify(const vector<T> &data) {
-        vector<float> r(data.size());
-        for (size_t ix = 0; ix < data.size(); ++ix)
-            r[ix] = (float)data[ix];
-        return r;
-    }
+   public:
+    traceDataMan_cl() {}
 
-    // converts vector by casting elements individually
-    template <typename Tin, typename Tout>
-    static vector<Tout> castVector(const vector<Tin> &data) {
-        vector<Tout> r(data.size());
-        for (size_t ix = 0; ix < data.size(); ++ix)
-            r[ix] = (Tout)data[ix];
-        return r;
+    // binary data files are memory-mapped instead of read (-mmap)
+    void setMapFiles(bool mapFiles) {
+        this->mapFiles = mapFiles;
     }
 
-    // converts vector to uint16_t by casting elements individually
-    template <typename Tin>
-    static vector<uint16_t> castVectorToUint16(const vector<Tin> &data) {
-        return castVector<Tin, uint16_t>(data);
+    // binary data of ref is memory-mapped as with -mmap, where possible, once it is loaded (-reorder: the reordered copy is the only one in process memory)
+    void setMapped(const string &ref) {
+        if (ref != "")
+            mappedRefs.insert(canonicalRef(ref));
     }
 
-    // converts vector to uint32_t by casting elements individually
-    template <typename Tin>
-    static vector<uint32_t> castVectorToUint32(const vector<Tin> &data) {
-        return castVector<Tin, uint32_t>(data);
+    // binary data files wider than 16 bits are memory-mapped and get 16 bit codes for rendering (-compact, see column_cl::quantized)
+    void setCompact(bool compact) {
+        this->compact = compact;
     }
 
-   public:
-    traceDataMan_cl() {}
+    // plain binary and text (.txt) data files are watched for appended data, see updateStreams (-follow)
+    void setFollow(bool follow) {
+        this->follow = follow;
+    }
 
-    // returns contents of a given datafile as 32-bit float vector
-    const vector<float> *getFloatVec(const string &filename) {
-        if (filename == "")
-            return NULL;
+    // enables the persistent cache of converted data in dir, limited to maxBytes in total (-cacheDir, -cacheMaxMB)
+    void setCacheDir(const string &dir, uint64_t maxBytes) {
+        cache = std::make_unique<dataCache_cl>(dir, maxBytes);
+    }
 
-        string fnCan = std::filesystem::canonical(filename).string();
-        loadAsFloat(fnCan);  // note: underlying 'map' container does NOT invalidate iterators on insertion (= pointers previously returned)
-        return &floatDataByFilename.at(fnCan);
+    // registers a data reference that will be requested later. For a CSV column, all registered columns of the file are parsed together when one of them is first requested
+    // asText: the column will be requested via getAsciiVec
+    void announce(const string &ref, bool asText = false) {
+        string filename;
+        string column;
+        if ((ref == "") || !splitColumnRef(ref, filename, column) || isArrowExt(std::filesystem::path(filename).extension().string()))
+            return;  // not CSV
+        const string fnCan = std::filesystem::canonical(filename).string();
+        (asText ? announcedTextColumns : announcedNumColumns)[fnCan].push_back(column);
     }
 
-    // returns contents of a given datafile as 16-bit unsigned vector
-    const vector<uint16_t> *getUInt16Vec(const string &filename) {
+    // returns contents of a given datafile in its native element type
+    const column_cl *getColumn(const string &filename) {
         if (filename == "")
             return NULL;
 
-        string fnCan = std::filesystem::canonical(filename).string();
-        loadAsUInt16(fnCan);  // note: underlying 'map' container does NOT invalidate iterators on insertion (= pointers previously returned)
-        return &uint16DataByFilename.at(fnCan);
+        string fnCan = canonicalRef(filename);
+        loadColumn(fnCan);  // note: underlying 'map' container does NOT invalidate iterators on insertion (= pointers previously returned)
+        return &columnsByFilename.at(fnCan).native;
     }
 
-    // returns contents of a given datafile as 32-bit unsigned vector
-    const vector<uint32_t> *getUInt32Vec(const string &filename) {
+    // returns contents of a given datafile with element type T, for random access. Data of another native type is converted once, on first use.
+    template <typename T>
+    const column_cl *getColumnAs(const string &filename) {
         if (filename == "")
             return NULL;
 
-        string fnCan = std::filesystem::canonical(filename).string();
-        loadAsUInt32(fnCan);  // note: underlying 'map' container does NOT invalidate iterators on insertion (= pointers previously returned)
-        return &uint32DataByFilename.at(fnCan);
+        string fnCan = canonicalRef(filename);
+        loadColumn(fnCan);
+        columnEntry_cl &e = columnsByFilename.at(fnCan);
+        if (e.native.getNative<T>())
+            return &e.native;
+        const column_cl::type_e type = column_cl::getTypeOf<T>();
+        if (e.converted.count(type) == 0)
+            e.converted[type] = e.native.convert<T>();
+        return &e.converted.at(type);
     }
 
     // returns contents of a given file (e.g. annotations) as literal ASCII text
@@ -81,11 +106,112 @@ class traceDataMan_cl {
         if (filename == "")
             return NULL;
 
-        string fnCan = std::filesystem::canonical(filename).string();
+        string fnCan = canonicalRef(filename);
         loadAsLiteralAscii(fnCan);
         return &asciiDataByFilename.at(fnCan);
     }
 
+    // whether a data reference is read as a stream (stdin "-" or a named pipe, see streamSource_cl)
+    bool isStream(const string &ref) const {
+        string filename;
+        string type;
+        return (ref != "") && splitStreamRef(ref, filename, type);
+    }
+
+    // whether the data of a reference may grow: streamed, or a followed file (see setFollow)
+    bool isGrowing(const string &ref) const {
+        return isStream(ref) || (follow && isFollowable(ref));
+    }
+
+    // takes over data that has arrived on streams or was appended to followed files since the last call, into the columns returned by getColumn / getColumnAs (same pointers).
+    // Only the new elements are rebased (64 bit data) or converted (getColumnAs). Returns true if any column has grown
+    bool updateStreams() {
+        bool changed = false;
+        for (auto &[ref, stream] : streamsByRef) {
+            stream.source->poll();
+            columnEntry_cl &e = columnsByFilename.at(ref);
+            if (stream.source->size() == e.native.size())
+                continue;
+            e.native = stream.getColumn(e.native);
+            for (auto &[type, c] : e.converted)
+                c = convertExtendedTo(e.native, c, type, stream.convertedStorage[type]);
+            changed = true;
+        }
+        return changed;
+    }
+
+    // whether any data may grow (see updateStreams)
+    bool hasStreams() const {
+        return !streamsByRef.empty();
+    }
+
+    // file that a data reference reads from (canonical, see getSourceFiles)
+    static string getSource(const string &ref) {
+        return getSourceFile(canonicalRef(ref));
+    }
+
+    // files of the data that has been loaded, except data that grows (see isGrowing)
+    vector<string> getSourceFiles() const {
+        std::set<string> r;
+        for (const auto &[ref, e] : columnsByFilename)
+            if (streamsByRef.count(ref) == 0)
+                r.insert(getSourceFile(ref));
+        for (const auto &[ref, lines] : asciiDataByFilename)
+            r.insert(getSourceFile(ref));
+        return vector<string>(r.begin(), r.end());
+    }
+
+    // loads the data from a source file (see getSourceFiles) again, e.g. after it has been rewritten. Replaces the columns returned by getColumn / getColumnAs
+    // and the text returned by getAsciiVec in place (same pointers): the caller must hold off their users. On failure, the previous data is kept and the exception passed on
+    void reload(const string &sourceFile) {
+        if (!std::filesystem::exists(sourceFile))
+            throw runtime_error("file not found: " + sourceFile);  // (e.g. removed before being written again)
+        // === take out the entries of the file (their address stays valid), load as new ===
+        vector<decltype(columnsByFilename)::node_type> columns;
+        vector<decltype(asciiDataByFilename)::node_type> texts;
+        for (auto it = columnsByFilename.begin(); it != columnsByFilename.end();) {
+            auto itNext = std::next(it);
+            if ((streamsByRef.count(it->first) == 0) && (getSourceFile(it->first) == sourceFile))
+                columns.push_back(columnsByFilename.extract(it));
+            it = itNext;
+        }
+        for (auto it = asciiDataByFilename.begin(); it != asciiDataByFilename.end();) {
+            auto itNext = std::next(it);
+            if (getSourceFile(it->first) == sourceFile)
+                texts.push_back(asciiDataByFilename.extract(it));
+            it = itNext;
+        }
+        std::exception_ptr err;
+        try {
+            for (auto &node : columns)
+                loadColumn(node.key());
+            for (auto &node : texts)
+                loadAsLiteralAscii(node.key());
+        } catch (...) {
+            err = std::current_exception();
+        }
+
+        // === put the entries back, with the new data ===
+        for (auto &node : columns) {
+            if (!err) {
+                columnEntry_cl &e = node.mapped();
+                e.native = columnsByFilename.at(node.key()).native;
+                for (auto &[type, c] : e.converted)
+                    c = convertTo(e.native, type);
+            }
+            columnsByFilename.erase(node.key());
+            columnsByFilename.insert(std::move(node));
+        }
+        for (auto &node : texts) {
+            if (!err)
+                node.mapped().swap(asciiDataByFilename.at(node.key()));
+            asciiDataByFilename.erase(node.key());
+            asciiDataByFilename.insert(std::move(node));
+        }
+        if (err)
+            std::rethrow_exception(err);
+    }
+
 #if 0
     const vector<const vector<string> *> getAsciiVecs(const vector<string> &filenames) {
         vector<const vector<string> *> r;
@@ -96,115 +222,603 @@ class traceDataMan_cl {
 #endif
 
    protected:
-    map<string, vector<float>> floatDataByFilename;
-    map<string, vector<uint16_t>> uint16DataByFilename;
-    map<string, vector<uint32_t>> uint32DataByFilename;
+    // one data file, held once in its native type
+    class columnEntry_cl {
+       public:
+        column_cl native;
+        // converted copies for getColumnAs
+        map<column_cl::type_e, column_cl> converted;
+    };
+
+    // key: canonical filename, or for a CSV column: canonical filename:column
+    map<string, columnEntry_cl> columnsByFilename;
     map<string, vector<string>> asciiDataByFilename;
+    // see setMapFiles()
+    bool mapFiles = false;
+    // canonical references, see setMapped()
+    std::set<string> mappedRefs;
+    // see setCompact()
+    bool compact = false;
+    // see setFollow()
+    bool follow = false;
+    // persistent cache of converted data (NULL: disabled)
+    std::unique_ptr<dataCache_cl> cache;
+    // CSV columns per canonical filename, see announce()
+    map<string, vector<string>> announcedNumColumns;
+    map<string, vector<string>> announcedTextColumns;
+    // data that grows (streamed or followed), see updateStreams
+    struct stream_t {
+        std::shared_ptr<streamSource_cl> source;
+        // stream: file ("-": stdin) and type as in splitStreamRef (empty: followed file)
+        string streamFile;
+        string streamType;
+        // offsets of 64 bit data, see column_cl::rebasedExtended
+        std::shared_ptr<vector<float>> offsets;
+        // per type of getColumnAs: vector of that type, see column_cl::convertedExtended
+        map<column_cl::type_e, std::shared_ptr<void>> convertedStorage;
 
-    // loads data for retrieval by its filename as 32-bit float vector
-    void loadAsFloat(const string &filename) {
-        if (floatDataByFilename.count(filename) > 0)
-            return;
+        // data that has arrived, extending prev (the result of the last call)
+        column_cl getColumn(const column_cl &prev) {
+            column_cl c = source->getColumn();
+            const column_cl::type_e t = c.getType();
+            if ((t == column_cl::DOUBLE) || (t == column_cl::INT64) || (t == column_cl::UINT64))
+                return c.rebasedExtended(prev, offsets);
+            return c;
+        }
+    };
+    // by data reference
+    map<string, stream_t> streamsByRef;
 
-        // file extension identifies input data format
-        string ext = std::filesystem::path(filename).extension().string();
+    // file that a canonical data reference reads from
+    static string getSourceFile(const string &ref) {
+        string filename;
+        string column;
+        recordField_t field;
+        npyRef_t npyRef;
+        if (splitRecordRef(ref, filename, field) || splitNpyRef(ref, filename, npyRef))
+            return filename;
+        return splitColumnRef(ref, filename, column) ? filename : ref;
+    }
 
-        if (aCCb::caseInsensitiveStringCompare(".float", ext))
-            floatDataByFilename[filename] = file2vec<float>(filename);
-        else if (aCCb::caseInsensitiveStringCompare(".double", ext))
-            floatDataByFilename[filename] = floatify(file2vec<double>(filename));
-        else if (aCCb::caseInsensitiveStringCompare(".int8", ext))
-            floatDataByFilename[filename] = floatify(file2vec<int8_t>(filename));
-        else if (aCCb::caseInsensitiveStringCompare(".uint8", ext))
-            floatDataByFilename[filename] = floatify(file2vec<uint8_t>(filename));
-        else if (aCCb::caseInsensitiveStringCompare(".int16", ext))
-            floatDataByFilename[filename] = floatify(file2vec<int16_t>(filename));
-        else if (aCCb::caseInsensitiveStringCompare(".uint16", ext))
-            floatDataByFilename[filename] = floatify(file2vec<uint16_t>(filename));
-        else if (aCCb::caseInsensitiveStringCompare(".int32", ext))
-            floatDataByFilename[filename] = floatify(file2vec<int32_t>(filename));
-        else if (aCCb::caseInsensitiveStringCompare(".uint32", ext))
-            floatDataByFilename[filename] = floatify(file2vec<uint32_t>(filename));
-        else if (aCCb::caseInsensitiveStringCompare(".int64", ext))
-            floatDataByFilename[filename] = floatify(file2vec<int64_t>(filename));
-        else if (aCCb::caseInsensitiveStringCompare(".uint64", ext))
-            floatDataByFilename[filename] = floatify(file2vec<uint64_t>(filename));
-        else if (aCCb::caseInsensitiveStringCompare(".txt", ext))
-            floatDataByFilename[filename] = loadFloatVecFromTxt(filename);
-        else
-            throw aCCb::argObjException("unsupported data file extension (" + filename + ")");
+    // whether data is taken from the persistent cache: only if it is parsed from text
+    bool isCached(const string &ref) const {
+        string filename;
+        recordField_t field;
+        if (!cache || splitRecordRef(ref, filename, field) || isGrowing(ref))
+            return false;
+        const string ext = std::filesystem::path(getSourceFile(ref)).extension().string();
+        return aCCb::caseInsensitiveStringCompare(".txt", ext) || isCsvExt(ext);
     }
 
-    // loads data for retrieval by its filename as 16-bit unsigned integer vector
-    void loadAsUInt16(const string &filename) {
-        if (filename == "")
-            return;
-        if (uint16DataByFilename.count(filename) > 0)
-            return;
+    // loads parsed data from the persistent cache. Returns false if disabled, not needed or not found
+    bool loadFromCache(const string &ref) {
+        if (!isCached(ref))
+            return false;
+        vector<float> data;
+        if (!cache->load(ref, getSourceFile(ref), data))
+            return false;
+        columnsByFilename[ref].native = column_cl(std::move(data));
+        return true;
+    }
 
-        // file extension identifies input data format
-        string ext = std::filesystem::path(filename).extension().string();
+    void storeToCache(const string &ref, const vector<float> &data) {
+        if (isCached(ref))
+            cache->store(ref, getSourceFile(ref), data);
+    }
+
+    static bool isCsvExt(const string &ext) {
+        return aCCb::caseInsensitiveStringCompare(".csv", ext) || aCCb::caseInsensitiveStringCompare(".tsv", ext);
+    }
+
+    static bool isArrowExt(const string &ext) {
+        return aCCb::caseInsensitiveStringCompare(".arrow", ext) || aCCb::caseInsensitiveStringCompare(".feather", ext);
+    }
+
+    // splits a column reference "file.csv:column", "file.tsv:column" or "file.arrow:column" (also .feather. column: header name or index, base 0). Returns false for a plain filename
+    static bool splitColumnRef(const string &ref, string &filename, string &column) {
+        const size_t ixColon = ref.rfind(':');
+        if (ixColon == string::npos)
+            return false;
+        const string fn = ref.substr(0, ixColon);
+        const string ext = std::filesystem::path(fn).extension().string();
+        if (!isCsvExt(ext) && !isArrowExt(ext))
+            return false;  // e.g. drive letter
+        filename = fn;
+        column = ref.substr(ixColon + 1);
+        return true;
+    }
+
+    // one field of a binary record file, see splitRecordRef
+    struct recordField_t {
+        // element type as binary file extension e.g. ".float" (empty: extension of the file)
+        string type;
+        // bytes per record (0: element size, no gaps)
+        size_t stride = 0;
+        // bytes from the start of the file to the field of the first record (field position in the record, plus any file header)
+        size_t offset = 0;
+        // byte order of the file (data is otherwise native, little endian). Packed samples: bit order
+        bool bigEndian = false;
+        // packed samples are two's complement
+        bool isSigned = false;
+        // number of records (max: as many as the file holds)
+        size_t count = std::numeric_limits<size_t>::max();
+    };
+
+    // splits a record field reference "file:stride=10,offset=4,type=float,endian=big" (all keys optional). Returns false for a plain filename
+    static bool splitRecordRef(const string &ref, string &filename, recordField_t &field) {
+        const size_t ixColon = ref.rfind(':');
+        if (ixColon == string::npos)
+            return false;
+        const string desc = ref.substr(ixColon + 1);
+        if ((desc.find('=') == string::npos) || (desc.find_first_of("/\\") != string::npos))
+            return false;  // e.g. drive letter
+        if (isNpyExt(std::filesystem::path(ref.substr(0, ixColon)).extension().string()))
+            return false;  // see splitNpyRef
+        recordField_t r;
+        size_t ixBegin = 0;
+        while (ixBegin <= desc.size()) {
+            size_t ixEnd = desc.find(',', ixBegin);
+            if (ixEnd == string::npos)
+                ixEnd = desc.size();
+            const string item = desc.substr(ixBegin, ixEnd - ixBegin);
+            ixBegin = ixEnd + 1;
+            const size_t ixEq = item.find('=');
+            const string key = item.substr(0, ixEq);
+            const string val = (ixEq == string::npos) ? "" : item.substr(ixEq + 1);
+            bool ok = (ixEq != string::npos);
+            if (key == "stride")
+                ok &= (val.find_first_not_of("0123456789") == string::npos) && aCCb::str2num(val, r.stride) && (r.stride > 0);
+            else if (key == "offset")
+                ok &= (val.find_first_not_of("0123456789") == string::npos) && aCCb::str2num(val, r.offset);
+            else if (key == "type") {
+                r.type = "." + val;
+                ok &= visitBinaryType(r.type, [](auto) {}) || (packedSamples_cl::getBits(r.type) != 0);
+            } else if ((key == "endian") && ((val == "big") || (val == "little")))
+                r.bigEndian = (val == "big");
+            else if ((key == "signed") && ((val == "0") || (val == "1")))
+                r.isSigned = (val == "1");
+            else
+                ok = false;
+            if (!ok)
+                throw aCCb::argObjException("invalid record field '" + item + "' in " + ref + " (expecting e.g. file.bin:stride=10,offset=4,type=float,endian=big)");
+        }
+        if (r.isSigned && !packedSamples_cl::getBits((r.type != "") ? r.type : std::filesystem::path(ref.substr(0, ixColon)).extension().string()))
+            throw aCCb::argObjException("'signed' applies to packed samples only e.g. file.packed12:signed=1 (" + ref + ")");
+        filename = ref.substr(0, ixColon);
+        field = r;
+        return true;
+    }
+
+    // splits a stream reference "-" (stdin), "-:type=float", or a named pipe "pipe.float", "pipe:type=float". type: binary file extension e.g. ".float", or ".txt" (one number per line, the default).
+    // Returns false for other references
+    static bool splitStreamRef(const string &ref, string &filename, string &type) {
+        string fn = ref;
+        recordField_t field;
+        if (splitRecordRef(ref, fn, field)) {
+            if (!streamSource_cl::isStream(fn))
+                return false;
+            if ((field.stride != 0) || (field.offset != 0) || field.bigEndian || field.isSigned || (field.count != std::numeric_limits<size_t>::max()))
+                throw aCCb::argObjException("streamed data accepts only type= e.g. -:type=float (" + ref + ")");
+        } else if (!streamSource_cl::isStream(ref))
+            return false;
+        type = (field.type != "") ? field.type : (fn == "-") ? "" : std::filesystem::path(fn).extension().string();
+        if (type == "")
+            type = ".txt";
+        if (!aCCb::caseInsensitiveStringCompare(".txt", type) && !visitBinaryType(type, [](auto) {}))
+            throw aCCb::argObjException("streamed data must be text (one number per line) or plain binary e.g. -:type=float (" + ref + ")");
+        filename = fn;
+        return true;
+    }
+
+    // whether a reference can be followed (see setFollow): a plain binary or text file
+    static bool isFollowable(const string &ref) {
+        const string ext = std::filesystem::path(ref).extension().string();
+        return aCCb::caseInsensitiveStringCompare(".txt", ext) || visitBinaryType(ext, [](auto) {});
+    }
+
+    // calls fn(T()) with the element type T of t
+    template <typename fn_t>
+    static auto visitColumnType(column_cl::type_e t, fn_t fn) {
+        switch (t) {
+            case column_cl::FLOAT:
+                return fn(float());
+            case column_cl::DOUBLE:
+                return fn(double());
+            case column_cl::INT8:
+                return fn(int8_t());
+            case column_cl::UINT8:
+                return fn(uint8_t());
+            case column_cl::INT16:
+                return fn(int16_t());
+            case column_cl::UINT16:
+                return fn(uint16_t());
+            case column_cl::INT32:
+                return fn(int32_t());
+            case column_cl::UINT32:
+                return fn(uint32_t());
+            case column_cl::INT64:
+                return fn(int64_t());
+            default:
+                return fn(uint64_t());
+        }
+    }
+
+    // c converted to element type t
+    static column_cl convertTo(const column_cl &c, column_cl::type_e t) {
+        return visitColumnType(t, [&c](auto v) { return c.convert<decltype(v)>(); });
+    }
+
+    // c converted to element type t, extending prev (see column_cl::convertedExtended). storage: a vector of that type (NULL for a start)
+    static column_cl convertExtendedTo(const column_cl &c, const column_cl &prev, column_cl::type_e t, std::shared_ptr<void> &storage) {
+        return visitColumnType(t, [&](auto v) {
+            auto typed = std::static_pointer_cast<vector<decltype(v)>>(storage);
+            const column_cl r = c.convertedExtended(prev, typed);
+            storage = typed;
+            return r;
+        });
+    }
+
+    // array of a NumPy file, see splitNpyRef
+    struct npyRef_t {
+        // array name in a .npz archive (empty: .npy file)
+        string member;
+        // selects a row or column of a 2D array
+        bool byRow = false;
+        bool byColumn = false;
+        size_t index = 0;
+    };
+
+    static bool isNpyExt(const string &ext) {
+        return aCCb::caseInsensitiveStringCompare(".npy", ext) || aCCb::caseInsensitiveStringCompare(".npz", ext);
+    }
+
+    // splits a NumPy array reference "file.npy", "file.npz:name", with a row or column of a 2D array "file.npy:row=2", "file.npz:name,col=3". Returns false for other files
+    static bool splitNpyRef(const string &ref, string &filename, npyRef_t &npyRef) {
+        string fn = ref;
+        string desc;
+        if (!isNpyExt(std::filesystem::path(ref).extension().string())) {
+            const size_t ixColon = ref.rfind(':');
+            if ((ixColon == string::npos) || !isNpyExt(std::filesystem::path(ref.substr(0, ixColon)).extension().string()))
+                return false;
+            fn = ref.substr(0, ixColon);
+            desc = ref.substr(ixColon + 1);
+        }
+        const bool isNpz = aCCb::caseInsensitiveStringCompare(".npz", std::filesystem::path(fn).extension().string());
+        npyRef_t r;
+        for (const string &item : aCCb::split(desc, ',')) {
+            const size_t ixEq = item.find('=');
+            const string key = item.substr(0, ixEq);
+            const string val = (ixEq == string::npos) ? "" : item.substr(ixEq + 1);
+            bool ok;
+            if (ixEq == string::npos) {
+                ok = isNpz && (r.member == "") && (item != "");
+                r.member = item;
+            } else if ((key == "row") || (key == "col")) {
+                ok = !r.byRow && !r.byColumn && (val.find_first_not_of("0123456789") == string::npos) && aCCb::str2num(val, r.index);
+                (key == "row" ? r.byRow : r.byColumn) = true;
+            } else
+                ok = false;
+            if (!ok)
+                throw aCCb::argObjException("invalid NumPy array selection '" + item + "' in " + ref + " (expecting e.g. file.npy:col=3 or file.npz:name,row=2)");
+        }
+        if (isNpz && (r.member == ""))
+            throw aCCb::argObjException(".npz file needs an array name e.g. " + ref + ":x (" + ref + ")");
+        filename = fn;
+        npyRef = r;
+        return true;
+    }
 
+    // calls fn(T()) for the element type T of a binary file extension e.g. ".float". Returns false if ext is not one
+    template <typename fn_t>
+    static bool visitBinaryType(const string &ext, fn_t fn) {
         if (aCCb::caseInsensitiveStringCompare(".float", ext))
-            uint16DataByFilename[filename] = castVectorToUint16(file2vec<float>(filename));
+            fn(float());
         else if (aCCb::caseInsensitiveStringCompare(".double", ext))
-            uint16DataByFilename[filename] = castVectorToUint16(file2vec<double>(filename));
+            fn(double());
         else if (aCCb::caseInsensitiveStringCompare(".int8", ext))
-            uint16DataByFilename[filename] = castVectorToUint16(file2vec<int8_t>(filename));
+            fn(int8_t());
         else if (aCCb::caseInsensitiveStringCompare(".uint8", ext))
-            uint16DataByFilename[filename] = castVectorToUint16(file2vec<uint8_t>(filename));
+            fn(uint8_t());
         else if (aCCb::caseInsensitiveStringCompare(".int16", ext))
-            uint16DataByFilename[filename] = castVectorToUint16(file2vec<int16_t>(filename));
+            fn(int16_t());
         else if (aCCb::caseInsensitiveStringCompare(".uint16", ext))
-            uint16DataByFilename[filename] = castVectorToUint16(file2vec<uint16_t>(filename));
+            fn(uint16_t());
         else if (aCCb::caseInsensitiveStringCompare(".int32", ext))
-            uint16DataByFilename[filename] = castVectorToUint16(file2vec<int32_t>(filename));
+            fn(int32_t());
         else if (aCCb::caseInsensitiveStringCompare(".uint32", ext))
-            uint16DataByFilename[filename] = castVectorToUint16(file2vec<uint32_t>(filename));
+            fn(uint32_t());
         else if (aCCb::caseInsensitiveStringCompare(".int64", ext))
-            uint16DataByFilename[filename] = castVectorToUint16(file2vec<int64_t>(filename));
+            fn(int64_t());
         else if (aCCb::caseInsensitiveStringCompare(".uint64", ext))
-            uint16DataByFilename[filename] = castVectorToUint16(file2vec<uint64_t>(filename));
-        else if (aCCb::caseInsensitiveStringCompare(".txt", ext))
-            uint16DataByFilename[filename] = castVectorToUint16(loadFloatVecFromTxt(filename));
+            fn(uint64_t());
         else
-            throw aCCb::argObjException("unsupported data file extension (" + filename + ")");
+            return false;
+        return true;
     }
 
-    // loads data for retrieval by its filename as 32-bit unsigned integer vector
-    void loadAsUInt32(const string &filename) {
-        if (filename == "")
+    // canonical filename, with column for a CSV column reference or field for a record field reference
+    static string canonicalRef(const string &ref) {
+        string filename;
+        string column;
+        recordField_t field;
+        npyRef_t npyRef;
+        if ((ref == "-") || (ref.rfind("-:", 0) == 0))
+            return ref;  // stdin
+        if (splitRecordRef(ref, filename, field) || (splitNpyRef(ref, filename, npyRef) && (filename != ref)))
+            return std::filesystem::canonical(filename).string() + ":" + ref.substr(ref.rfind(':') + 1);
+        if (splitColumnRef(ref, filename, column))
+            return std::filesystem::canonical(filename).string() + ":" + column;
+        const string ext = std::filesystem::path(ref).extension().string();
+        if (isCsvExt(ext) || isArrowExt(ext))
+            throw aCCb::argObjException((isCsvExt(ext) ? "CSV" : "Arrow") + string(" file needs a column e.g. ") + ref + ":0 (" + ref + ")");
+        return std::filesystem::canonical(ref).string();
+    }
+
+    // parses a CSV / TSV file once, for the given columns and all announced ones that are not loaded yet (numeric: float columnsByFilename, text: asciiDataByFilename)
+    // The first line is a header if any of its fields is not a number. Fields may be quoted ("..." with "" for a literal quote) but may not contain line breaks.
+    void loadCsvColumns(const string &filename, vector<string> numCols, vector<string> textCols) {
+        // === include announced columns ===
+        for (const string &col : announcedNumColumns[filename])
+            if (columnsByFilename.count(filename + ":" + col) == 0)
+                numCols.push_back(col);
+        for (const string &col : announcedTextColumns[filename])
+            if (asciiDataByFilename.count(filename + ":" + col) == 0)
+                textCols.push_back(col);
+
+        aCCb::mappedFile f(filename);
+        if (f.size() == 0)
+            throw aCCb::argObjException("CSV file is empty: " + filename);
+        const char *pBegin = f.data();
+        const char *pEnd = pBegin + f.size();
+        const char sep = aCCb::caseInsensitiveStringCompare(".tsv", std::filesystem::path(filename).extension().string()) ? '\t' : ',';
+
+        // === header ===
+        const char *pNl = f.size() ? (const char *)memchr(pBegin, '\n', f.size()) : NULL;
+        vector<string> firstRow;
+        string buf;
+        forEachCsvField(pBegin, pNl ? pNl : pEnd, sep, std::numeric_limits<size_t>::max(), buf, [&firstRow](size_t, const char *pFieldBegin, const char *pFieldEnd) {
+            firstRow.push_back(string(pFieldBegin, pFieldEnd));
+        });
+        bool hasHeader = false;
+        for (const string &field : firstRow) {
+            char *endptr;
+            std::strtof(field.c_str(), &endptr);
+            hasHeader |= (endptr == field.c_str());
+        }
+
+        // === columns to fields ===
+        auto getField = [&](const string &col) {
+            if (hasHeader)
+                for (size_t ix = 0; ix < firstRow.size(); ++ix)
+                    if (firstRow[ix] == col)
+                        return ix;
+            size_t ix;
+            if ((col.find_first_not_of("0123456789") != string::npos) || !aCCb::str2num(col, ix) || (ix >= firstRow.size()))
+                throw aCCb::argObjException("CSV column not found: " + filename + ":" + col);
+            return ix;
+        };
+        // output slot per field (-1: not used)
+        vector<int> numSlotByField(firstRow.size(), -1);
+        vector<int> textSlotByField(firstRow.size(), -1);
+        vector<size_t> numFields;
+        vector<size_t> textFields;
+        for (const string &col : numCols) {
+            size_t ixField = getField(col);
+            if (numSlotByField[ixField] < 0) {
+                numSlotByField[ixField] = numFields.size();
+                numFields.push_back(ixField);
+            }
+        }
+        for (const string &col : textCols) {
+            size_t ixField = getField(col);
+            if (textSlotByField[ixField] < 0) {
+                textSlotByField[ixField] = textFields.size();
+                textFields.push_back(ixField);
+            }
+        }
+        size_t maxField = 0;
+        for (size_t ixField : numFields)
+            maxField = std::max(maxField, ixField);
+        for (size_t ixField : textFields)
+            maxField = std::max(maxField, ixField);
+
+        // === parse all lines in parallel (missing fields: NAN or empty string) ===
+        const lineBlocks_cl blocks(pBegin, pEnd);
+        const size_t nRows = blocks.getNLines() - (hasHeader ? 1 : 0);  // (header only: none)
+        vector<vector<float>> numData(numFields.size(), vector<float>(nRows, std::numeric_limits<float>::quiet_NaN()));
+        vector<vector<string>> textData(textFields.size(), vector<string>(nRows));
+        // per block and numeric column: number of integer fields, and whether one is beyond float precision
+        vector<vector<size_t>> nIntFields(blocks.getNBlocks(), vector<size_t>(numFields.size()));
+        vector<vector<char>> hasInexactInt(blocks.getNBlocks(), vector<char>(numFields.size()));
+        runParallel(blocks.getNBlocks(), [&](size_t ixBlock) {
+            string buf;
+            blocks.forEachLine(ixBlock, [&](size_t ixLine, const char *pLineBegin, const char *pLineEnd) {
+                if (hasHeader && (ixLine == 0))
+                    return;
+                const size_t ixRow = ixLine - (hasHeader ? 1 : 0);
+                forEachCsvField(pLineBegin, pLineEnd, sep, maxField, buf, [&](size_t ixField, const char *pFieldBegin, const char *pFieldEnd) {
+                    const int ixNum = numSlotByField[ixField];
+                    int64_t v;
+                    if ((ixNum >= 0) && parseIntField(pFieldBegin, pFieldEnd, v)) {
+                        numData[ixNum][ixRow] = (float)v;
+                        ++nIntFields[ixBlock][ixNum];
+                        hasInexactInt[ixBlock][ixNum] |= (v > maxExactFloatInt) || (v < -maxExactFloatInt);
+                    } else if (ixNum >= 0)
+                        numData[ixNum][ixRow] = parseFloatLine(pFieldBegin, pFieldEnd);
+                    if (textSlotByField[ixField] >= 0)
+                        textData[textSlotByField[ixField]][ixRow].assign(pFieldBegin, pFieldEnd);
+                });
+            });
+        });
+
+        // === integer columns beyond float precision (e.g. -annot2 indices, timestamps) are parsed again, exactly as int64 ===
+        vector<vector<int64_t>> intData(numFields.size());
+        bool hasIntData = false;
+        for (size_t ixNum = 0; ixNum < numFields.size(); ++ixNum) {
+            size_t nInt = 0;
+            bool inexact = false;
+            for (size_t ixBlock = 0; ixBlock < blocks.getNBlocks(); ++ixBlock) {
+                nInt += nIntFields[ixBlock][ixNum];
+                inexact |= hasInexactInt[ixBlock][ixNum] != 0;
+            }
+            if (inexact && (nInt == nRows)) {
+                intData[ixNum].resize(nRows);
+                hasIntData = true;
+            }
+        }
+        if (hasIntData)
+            runParallel(blocks.getNBlocks(), [&](size_t ixBlock) {
+                string buf;
+                blocks.forEachLine(ixBlock, [&](size_t ixLine, const char *pLineBegin, const char *pLineEnd) {
+                    if (hasHeader && (ixLine == 0))
+                        return;
+                    const size_t ixRow = ixLine - (hasHeader ? 1 : 0);
+                    forEachCsvField(pLineBegin, pLineEnd, sep, maxField, buf, [&](size_t ixField, const char *pFieldBegin, const char *pFieldEnd) {
+                        const int ixNum = numSlotByField[ixField];
+                        if ((ixNum >= 0) && !intData[ixNum].empty())
+                            parseIntField(pFieldBegin, pFieldEnd, intData[ixNum][ixRow]);
+                    });
+                });
+            });
+
+        // === store by column reference (the same field may be referenced by name and index) ===
+        for (const string &col : numCols)
+            if (intData[numSlotByField[getField(col)]].empty())  // (the cache holds float)
+                storeToCache(filename + ":" + col, numData[numSlotByField[getField(col)]]);
+        vector<column_cl> numColumns;
+        for (size_t ixNum = 0; ixNum < numFields.size(); ++ixNum)
+            numColumns.push_back(intData[ixNum].empty() ? column_cl(std::move(numData[ixNum])) : column_cl(std::move(intData[ixNum])));
+        for (const string &col : numCols)
+            columnsByFilename[filename + ":" + col].native = numColumns[numSlotByField[getField(col)]];
+        for (const string &col : textCols)
+            asciiDataByFilename[filename + ":" + col] = textData[textSlotByField[getField(col)]];
+    }
+
+    // calls fn(ixField, pFieldBegin, pFieldEnd) for fields 0..maxField of a CSV line (quotes removed, a trailing '\r' is ignored). buf: scratch space for quoted fields
+    template <typename fn_t>
+    static void forEachCsvField(const char *p, const char *pLineEnd, char sep, size_t maxField, string &buf, fn_t fn) {
+        if ((pLineEnd > p) && (pLineEnd[-1] == '\r'))
+            --pLineEnd;
+        for (size_t ixField = 0; ixField <= maxField; ++ixField) {
+            if ((p < pLineEnd) && (*p == '"')) {
+                // === quoted field ===
+                buf.clear();
+                for (++p; p < pLineEnd; ++p) {
+                    if (*p == '"') {
+                        if ((p + 1 < pLineEnd) && (p[1] == '"'))
+                            ++p;  // escaped quote
+                        else {
+                            ++p;
+                            break;
+                        }
+                    }
+                    buf.push_back(*p);
+                }
+                fn(ixField, buf.data(), buf.data() + buf.size());
+            } else {
+                const char *pSep = (const char *)memchr(p, sep, pLineEnd - p);
+                fn(ixField, p, pSep ? pSep : pLineEnd);
+                if (pSep)
+                    p = pSep;
+                else
+                    p = pLineEnd;
+            }
+            // === next field ===
+            const char *pSep = (const char *)memchr(p, sep, pLineEnd - p);
+            if (!pSep)
+                return;
+            p = pSep + 1;
+        }
+    }
+
+    // loads data for retrieval by its filename in its native type
+    void loadColumn(const string &filename) {
+        if (columnsByFilename.count(filename) > 0)
+            return;
+        if (loadFromCache(filename))
             return;
-        if (uint32DataByFilename.count(filename) > 0)
+
+        string csvFilename;
+        string column;
+        string recordFilename;
+        recordField_t field;
+        string streamType;
+        if (splitStreamRef(filename, recordFilename, streamType)) {
+            // === one reader per stream, e.g. stdin used by several references ===
+            for (const auto &[ref, st] : streamsByRef)
+                if (st.streamFile == recordFilename) {
+                    if (!aCCb::caseInsensitiveStringCompare(st.streamType, streamType))
+                        throw aCCb::argObjException("a stream is read as one type (" + ref + ", " + filename + ")");
+                    addStream(filename, st.source, recordFilename, streamType);
+                    return;
+                }
+            // (no -compact or -mmap: the data grows)
+            std::shared_ptr<streamSource_cl> s;
+            if (!visitBinaryType(streamType, [&](auto t) { s = streamSource_cl::open<decltype(t)>(recordFilename); }))
+                s = streamSource_cl::open<float>(recordFilename, parseFloatLine);
+            addStream(filename, s, recordFilename, streamType);
+            return;
+        }
+        if (follow && isFollowable(filename)) {
+            std::shared_ptr<streamSource_cl> s;
+            if (!visitBinaryType(std::filesystem::path(filename).extension().string(), [&](auto t) { s = streamSource_cl::follow<decltype(t)>(filename); }))
+                s = streamSource_cl::follow<float>(filename, parseFloatLine);
+            addStream(filename, s);
+            return;
+        }
+        if (splitRecordRef(filename, recordFilename, field)) {
+            const string type = (field.type != "") ? field.type : std::filesystem::path(recordFilename).extension().string();
+            if (const int bits = packedSamples_cl::getBits(type)) {
+                columnsByFilename[filename].native = loadPacked(filename, recordFilename, field, bits);
+                return;
+            }
+            column_cl c;
+            if (!visitBinaryType(type, [&](auto t) { c = loadRecordField<decltype(t)>(filename, recordFilename, field); }))
+                throw aCCb::argObjException("record field needs a type e.g. type=float (" + filename + ")");
+            columnsByFilename[filename].native = std::move(c);
+            return;
+        }
+        npyRef_t npyRef;
+        if (splitNpyRef(filename, recordFilename, npyRef)) {
+            columnsByFilename[filename].native = loadNpy(filename, recordFilename, npyRef);
+            return;
+        }
+        if (splitColumnRef(filename, csvFilename, column)) {
+            if (isArrowExt(std::filesystem::path(csvFilename).extension().string()))
+                columnsByFilename[filename].native = loadArrowColumn(csvFilename, column);
+            else
+                loadCsvColumns(csvFilename, {column}, {});
             return;
+        }
 
         // file extension identifies input data format
         string ext = std::filesystem::path(filename).extension().string();
 
-        if (aCCb::caseInsensitiveStringCompare(".float", ext))
-            uint32DataByFilename[filename] = castVectorToUint32(file2vec<float>(filename));
-        else if (aCCb::caseInsensitiveStringCompare(".double", ext))
-            uint32DataByFilename[filename] = castVectorToUint32(file2vec<double>(filename));
-        else if (aCCb::caseInsensitiveStringCompare(".int8", ext))
-            uint32DataByFilename[filename] = castVectorToUint32(file2vec<int8_t>(filename));
-        else if (aCCb::caseInsensitiveStringCompare(".uint8", ext))
-            uint32DataByFilename[filename] = castVectorToUint32(file2vec<uint8_t>(filename));
-        else if (aCCb::caseInsensitiveStringCompare(".int16", ext))
-            uint32DataByFilename[filename] = castVectorToUint32(file2vec<int16_t>(filename));
-        else if (aCCb::caseInsensitiveStringCompare(".uint16", ext))
-            uint32DataByFilename[filename] = castVectorToUint32(file2vec<uint16_t>(filename));
-        else if (aCCb::caseInsensitiveStringCompare(".int32", ext))
-            uint32DataByFilename[filename] = castVectorToUint32(file2vec<int32_t>(filename));
-        else if (aCCb::caseInsensitiveStringCompare(".uint32", ext))
-            uint32DataByFilename[filename] = castVectorToUint32(file2vec<uint32_t>(filename));
-        else if (aCCb::caseInsensitiveStringCompare(".int64", ext))
-            uint32DataByFilename[filename] = castVectorToUint32(file2vec<int64_t>(filename));
-        else if (aCCb::caseInsensitiveStringCompare(".uint64", ext))
-            uint32DataByFilename[filename] = castVectorToUint32(file2vec<uint64_t>(filename));
-        else if (aCCb::caseInsensitiveStringCompare(".txt", ext))
-            uint32DataByFilename[filename] = castVectorToUint32(loadFloatVecFromTxt(filename));
-        else
+        column_cl c;
+        if (const int bits = packedSamples_cl::getBits(ext)) {
+            c = loadPacked(filename, filename, recordField_t(), bits);
+        } else if (compressedFile_cl::isCompressedExt(ext)) {
+            // e.g. x.float.zst
+            const string innerExt = std::filesystem::path(filename).stem().extension().string();
+            if (!visitBinaryType(innerExt, [&](auto t) { c = finishBinary<decltype(t)>(column_cl(compressedFile_cl::load<decltype(t)>(filename, ext)), /*mapped*/ false); }))
+                throw aCCb::argObjException("compressed file needs a binary data type e.g. x.float" + ext + " (" + filename + ")");
+        } else if (visitBinaryType(ext, [&](auto t) { c = loadBinary<decltype(t)>(filename); })) {
+        } else if (aCCb::caseInsensitiveStringCompare(".txt", ext)) {
+            vector<float> data = loadFloatVecFromTxt(filename);
+            storeToCache(filename, data);
+            c = column_cl(std::move(data));
+        } else
             throw aCCb::argObjException("unsupported data file extension (" + filename + ")");
+        columnsByFilename[filename].native = std::move(c);
+    }
+
+    // data reference ref reads from s (see updateStreams). streamFile, streamType: see stream_t
+    void addStream(const string &ref, std::shared_ptr<streamSource_cl> s, const string &streamFile = "", const string &streamType = "") {
+        stream_t &st = streamsByRef[ref];
+        st.source = s;
+        st.streamFile = streamFile;
+        st.streamType = streamType;
+        columnsByFilename[ref].native = st.getColumn(column_cl());
     }
 
     // loads literal ASCII data for retrieval by its filename
@@ -214,6 +828,22 @@ class traceDataMan_cl {
         if (asciiDataByFilename.count(filename) > 0)
             return;
 
+        string csvFilename;
+        string column;
+        if (splitColumnRef(filename, csvFilename, column)) {
+            if (isArrowExt(std::filesystem::path(csvFilename).extension().string()))
+                asciiDataByFilename[filename] = arrowFile_cl(csvFilename).getStrings(column);
+            else
+                loadCsvColumns(csvFilename, {}, {column});
+            return;
+        }
+        recordField_t field;
+        npyRef_t npyRef;
+        if (isStream(filename))
+            throw aCCb::argObjException("streamed data can't be used as text (" + filename + ")");
+        if (splitRecordRef(filename, csvFilename, field) || splitNpyRef(filename, csvFilename, npyRef))
+            throw aCCb::argObjException("binary data can't be used as text (" + filename + ")");
+
         std::ifstream is(filename);
         if (!is.is_open()) throw std::runtime_error("failed to open file (r): '" + filename + "')");
 
@@ -223,6 +853,200 @@ class traceDataMan_cl {
             r.push_back(line);
     }
 
+    // binary data file as column, memory-mapped (see setMapFiles) or read.
+    // Compact (see setCompact): with 16 bit codes for rendering, exact values stay in the mapped file.
+    // Otherwise, 64 bit data is rebased: float offsets from an origin per chunk keep the precision that matters for display, e.g. deep zoom into timestamps
+    template <class T>
+    column_cl loadBinary(const string &fname) const {
+        if (!isMapped(fname) && !(compact && (sizeof(T) > 2)))
+            return finishBinary<T>(column_cl(file2vec<T>(fname)), /*mapped*/ false);
+        auto f = std::make_shared<aCCb::mappedFile>(fname);
+        if (f->size() % sizeof(T) != 0)
+            throw runtime_error("binary file contains partial element: " + fname);
+        return finishBinary<T>(column_cl((const T *)f->data(), f->size() / sizeof(T), f), /*mapped*/ true);
+    }
+
+    // field of a binary record file (see splitRecordRef) as column. A contiguous field in native byte order is used as a plain binary file (see loadBinary),
+    // otherwise the field is copied out of the memory-mapped file in parallel (byte-swapped if needed), the other fields are not kept
+    template <class T>
+    column_cl loadRecordField(const string &ref, const string &fname, const recordField_t &field) const {
+        const size_t stride = field.stride ? field.stride : sizeof(T);
+        if (sizeof(T) > stride)
+            throw aCCb::argObjException("record field exceeds stride (" + ref + ")");
+        auto f = std::make_shared<aCCb::mappedFile>(fname);
+        size_t n = (f->size() >= field.offset + sizeof(T)) ? (f->size() - field.offset - sizeof(T)) / stride + 1 : 0;
+        if (field.count != std::numeric_limits<size_t>::max()) {
+            if (field.count > n)
+                throw runtime_error("file is too short for " + std::to_string(field.count) + " records: " + ref);
+            n = field.count;
+        }
+        if (n == 0)
+            return column_cl(vector<T>());
+        const char *pBegin = f->data() + field.offset;
+
+        // === contiguous: map ===
+        if ((stride == sizeof(T)) && !field.bigEndian && ((uintptr_t)pBegin % alignof(T) == 0) && (isMapped(ref) || (compact && (sizeof(T) > 2))))
+            return finishBinary<T>(column_cl((const T *)pBegin, n, f), /*mapped*/ true);
+
+        // === copy (memcpy: fields need not be aligned) ===
+        vector<T> r(n);
+        const size_t nBlocks = std::max(std::min((size_t)std::max(std::thread::hardware_concurrency(), 1u), n / 65536), (size_t)1);
+        const bool swap = field.bigEndian;
+        runParallel(nBlocks, [&](size_t ixBlock) {
+            const size_t ixBegin = n * ixBlock / nBlocks;
+            const size_t ixEnd = n * (ixBlock + 1) / nBlocks;
+            if (swap)
+                for (size_t ix = ixBegin; ix < ixEnd; ++ix) {
+                    T v;
+                    memcpy(&v, pBegin + ix * stride, sizeof(T));
+                    r[ix] = byteSwapped(v);
+                }
+            else
+                for (size_t ix = ixBegin; ix < ixEnd; ++ix)
+                    memcpy(&r[ix], pBegin + ix * stride, sizeof(T));
+        });
+        return finishBinary<T>(column_cl(std::move(r)), /*mapped*/ false);
+    }
+
+    // array of a NumPy file (see splitNpyRef) as column: a record field (see loadRecordField) over the payload, so a contiguous array in native byte order can be mapped without a copy
+    column_cl loadNpy(const string &ref, const string &filename, const npyRef_t &npyRef) const {
+        npyFile_cl::array_t a;
+        {
+            aCCb::mappedFile f(filename);
+            a = npyFile_cl::locate(f, filename, npyRef.member);
+        }
+        recordField_t field;
+        field.offset = a.dataOffset;
+        field.stride = a.elemSize;
+        field.bigEndian = a.bigEndian;
+        if (a.shape.size() <= 1) {
+            if (npyRef.byRow || npyRef.byColumn)
+                throw aCCb::argObjException("row / col selects from a 2D array (" + ref + ")");
+            field.count = a.shape.empty() ? 1 : a.shape[0];
+        } else if (a.shape.size() == 2) {
+            const size_t nRows = a.shape[0];
+            const size_t nCols = a.shape[1];
+            if (!npyRef.byRow && !npyRef.byColumn)
+                throw aCCb::argObjException("2D array needs a row or column e.g. " + ref + (npyRef.member == "" ? ":" : ",") + "col=0 (" + ref + ")");
+            if (npyRef.index >= (npyRef.byRow ? nRows : nCols))
+                throw aCCb::argObjException("row / col out of range, shape is " + std::to_string(nRows) + " x " + std::to_string(nCols) + " (" + ref + ")");
+            // (elements per step in the row / column index)
+            const size_t rowStep = a.fortranOrder ? 1 : nCols;
+            const size_t colStep = a.fortranOrder ? nRows : 1;
+            field.offset += npyRef.index * (npyRef.byRow ? rowStep : colStep) * a.elemSize;
+            field.stride = (npyRef.byRow ? colStep : rowStep) * a.elemSize;
+            field.count = npyRef.byRow ? nCols : nRows;
+        } else
+            throw aCCb::argObjException("array has more than 2 dimensions (" + ref + ")");
+        column_cl c;
+        if (!visitBinaryType(a.type, [&](auto t) { c = loadRecordField<decltype(t)>(ref, filename, field); }))
+            throw aCCb::argObjException("unsupported .npy dtype (" + ref + ")");
+        return c;
+    }
+
+    // numeric column of an Arrow IPC file (see arrowFile_cl). A single record batch without nulls is used in place like a plain binary file (-mmap, -compact),
+    // otherwise the batches are copied in parallel (bits of bool data unpacked, nulls NAN for float / double. Integer nulls keep their stored value)
+    column_cl loadArrowColumn(const string &filename, const string &column) const {
+        auto f = std::make_shared<const arrowFile_cl>(filename);
+        const arrowFile_cl::numColumn_t a = f->getNumeric(column);
+        column_cl c;
+        visitBinaryType(a.type, [&](auto t) { c = arrowToColumn<decltype(t)>(f, a, isMapped(filename + ":" + column)); });
+        return c;
+    }
+
+    template <class T>
+    column_cl arrowToColumn(const std::shared_ptr<const arrowFile_cl> &f, const arrowFile_cl::numColumn_t &a, bool map) const {
+        if ((a.chunks.size() == 1) && !a.hasNulls && !a.isBool && ((uintptr_t)a.chunks[0].pData % alignof(T) == 0) && (map || (compact && (sizeof(T) > 2))))
+            return finishBinary<T>(column_cl((const T *)a.chunks[0].pData, a.size, f), /*mapped*/ true);
+        vector<T> r(a.size);
+        vector<size_t> ixFirst{0};
+        for (const arrowFile_cl::chunk_t &c : a.chunks)
+            ixFirst.push_back(ixFirst.back() + c.length);
+        runParallel(a.chunks.size(), [&](size_t ixChunk) {
+            const arrowFile_cl::chunk_t &c = a.chunks[ixChunk];
+            T *pDest = r.data() + ixFirst[ixChunk];
+            if (a.isBool) {
+                for (size_t ix = 0; ix < c.length; ++ix)
+                    pDest[ix] = (T)((c.pData[ix / 8] >> (ix % 8)) & 1);
+            } else if (c.length)
+                memcpy(pDest, c.pData, c.length * sizeof(T));
+            if constexpr (std::is_floating_point_v<T>)
+                if (c.pValidity)
+                    for (size_t ix = 0; ix < c.length; ++ix)
+                        if (!((c.pValidity[ix / 8] >> (ix % 8)) & 1))
+                            pDest[ix] = std::numeric_limits<T>::quiet_NaN();
+        });
+        return finishBinary<T>(column_cl(std::move(r)), /*mapped*/ false);
+    }
+
+    // packed 10 / 12 bit samples (see packedSamples_cl) as int16 (signed) or uint16 column, unpacked from the memory-mapped file in parallel.
+    // From the record field: offset (file header), endian (bit order), signed, no stride
+    column_cl loadPacked(const string &ref, const string &fname, const recordField_t &field, int bits) const {
+        if (field.stride)
+            throw aCCb::argObjException("packed samples have no stride (" + ref + ")");
+        column_cl c;
+        if (field.isSigned)
+            c = loadPacked<int16_t>(ref, fname, field, bits);
+        else
+            c = loadPacked<uint16_t>(ref, fname, field, bits);
+        return c;
+    }
+
+    template <class T>
+    column_cl loadPacked(const string &ref, const string &fname, const recordField_t &field, int bits) const {
+        aCCb::mappedFile f(fname);
+        const size_t nBytes = (f.size() > field.offset) ? f.size() - field.offset : 0;
+        size_t n = packedSamples_cl::getCount(nBytes, bits);
+        if (field.count != std::numeric_limits<size_t>::max()) {
+            if (field.count > n)
+                throw runtime_error("file is too short for " + std::to_string(field.count) + " samples: " + ref);
+            n = field.count;
+        }
+        vector<T> r(n);
+        // blocks of whole groups (4 samples)
+        const size_t nGroups = (n + 3) / 4;
+        const size_t nBlocks = std::max(std::min((size_t)std::max(std::thread::hardware_concurrency(), 1u), n / 65536), (size_t)1);
+        runParallel(nBlocks, [&](size_t ixBlock) {
+            const size_t ixBegin = 4 * (nGroups * ixBlock / nBlocks);
+            const size_t ixEnd = std::min(4 * (nGroups * (ixBlock + 1) / nBlocks), n);
+            packedSamples_cl::unpack(f.data() + field.offset, nBytes, bits, field.bigEndian, ixBegin, ixEnd, r.data());
+        });
+        return column_cl(std::move(r));
+    }
+
+    // whether binary data of a canonical reference is memory-mapped (see setMapFiles, setMapped)
+    bool isMapped(const string &ref) const {
+        return mapFiles || (mappedRefs.count(ref) > 0);
+    }
+
+    // binary data after loading: compact (see setCompact) for mapped data, else 64 bit data is rebased
+    template <class T>
+    column_cl finishBinary(const column_cl &c, bool mapped) const {
+        if (compact && mapped && (sizeof(T) > 2))
+            return c.quantized();
+        return (sizeof(T) == 8) ? c.rebased() : c;
+    }
+
+    // v with reversed byte order (a single instruction, see packedSamples)
+    template <class T>
+    static T byteSwapped(T v) {
+        if constexpr (sizeof(T) == 1)
+            return v;
+        else {
+            typedef std::conditional_t<sizeof(T) == 2, uint16_t, std::conditional_t<sizeof(T) == 4, uint32_t, uint64_t>> bits_t;
+            bits_t b;
+            memcpy(&b, &v, sizeof(T));
+            if constexpr (sizeof(T) == 2)
+                b = __builtin_bswap16(b);
+            else if constexpr (sizeof(T) == 4)
+                b = __builtin_bswap32(b);
+            else
+                b = __builtin_bswap64(b);
+            memcpy(&v, &b, sizeof(T));
+            return v;
+        }
+    }
+
     //* Read binary data from file into vector */
     template <class T>
     static vector<T> file2vec(const string fname) {
@@ -239,30 +1063,145 @@ class traceDataMan_cl {
 
         is.seekg(0, std::ios_base::beg);
         vector<T> retVal(nElem);
-        is.read((char *)&retVal[0], nElem * sizeof(T));
+        is.read((char *)retVal.data(), nElem * sizeof(T));
         if (!is)
             throw runtime_error("read failed");
         return retVal;
     }
 
     // read ASCII data from file into float vector. Non-parseable lines are returned as NAN, trailing data after a parseable number is ignored
+    // The file is split at line boundaries into one block per thread, which are parsed in parallel.
     static vector<float> loadFloatVecFromTxt(const string &filename) {
-        vector<float> r;
-        r.reserve(1000000);  // smaller data is unlikely / "don't-care" wrt performance
+        aCCb::mappedFile f(filename);
+        const lineBlocks_cl blocks(f.data(), f.data() + f.size());
+        vector<float> r(blocks.getNLines());
+        runParallel(blocks.getNBlocks(), [&](size_t ixBlock) {
+            blocks.forEachLine(ixBlock, [&r](size_t ixLine, const char *pLineBegin, const char *pLineEnd) {
+                r[ixLine] = parseFloatLine(pLineBegin, pLineEnd);
+            });
+        });
+        return r;
+    }
 
-        std::ifstream is(filename, std::ifstream::binary);
-        if (!is)
-            throw std::runtime_error("failed to open file: " + filename);
+    // text split at line boundaries into one block per thread, for parallel parsing
+    class lineBlocks_cl {
+       public:
+        lineBlocks_cl(const char *pBegin, const char *pEnd) : blockBegin{pBegin} {
+            // === split ===
+            const size_t nBytes = pEnd - pBegin;
+            const size_t minBlockSize = 1 << 20;
+            size_t nBlocks = std::max(std::thread::hardware_concurrency(), 1u);
+            nBlocks = std::max(std::min(nBlocks, nBytes / minBlockSize), (size_t)1);
+            for (size_t ixBlock = 1; ixBlock < nBlocks; ++ixBlock) {
+                const char *p = std::max(pBegin + nBytes * ixBlock / nBlocks, blockBegin.back());
+                const char *pNl = (const char *)memchr(p, '\n', pEnd - p);
+                blockBegin.push_back(pNl ? pNl + 1 : pEnd);
+            }
+            blockBegin.push_back(pEnd);
 
-        string line;
-        while (std::getline(is, line)) {
+            // === count lines per block ===
+            vector<size_t> nLines(nBlocks);
+            runParallel(nBlocks, [this, &nLines](size_t ixBlock) {
+                size_t n = 0;
+                forEachLineOfBlock(ixBlock, 0, [&n](size_t, const char *, const char *) { ++n; });
+                nLines[ixBlock] = n;
+            });
+            firstLine.push_back(0);
+            for (size_t n : nLines)
+                firstLine.push_back(firstLine.back() + n);
+        }
+
+        size_t getNBlocks() const {
+            return blockBegin.size() - 1;
+        }
+
+        // number of lines (a last line without newline counts, as with std::getline)
+        size_t getNLines() const {
+            return firstLine.back();
+        }
+
+        // calls fn(ixLine, pLineBegin, pLineEnd) for each line of a block, in order ('\n' excluded)
+        template <typename fn_t>
+        void forEachLine(size_t ixBlock, fn_t fn) const {
+            forEachLineOfBlock(ixBlock, firstLine[ixBlock], fn);
+        }
+
+       protected:
+        template <typename fn_t>
+        void forEachLineOfBlock(size_t ixBlock, size_t ixLine, fn_t fn) const {
+            const char *pBlockEnd = blockBegin[ixBlock + 1];
+            for (const char *p = blockBegin[ixBlock]; p < pBlockEnd; ++ixLine) {
+                const char *pNl = (const char *)memchr(p, '\n', pBlockEnd - p);
+                const char *pLineEnd = pNl ? pNl : pBlockEnd;
+                fn(ixLine, p, pLineEnd);
+                p = pNl ? pNl + 1 : pBlockEnd;
+            }
+        }
+
+        // start of each block, and end of data
+        vector<const char *> blockBegin;
+        // index of the first line of each block, and number of lines
+        vector<size_t> firstLine;
+    };
+
+    // largest integer magnitude up to which float is exact
+    static const int64_t maxExactFloatInt = (int64_t)1 << 24;
+
+    // parses a field that is a plain decimal integer (optional '-', surrounding whitespace). Returns false otherwise (also out of int64 range)
+    static bool parseIntField(const char *pBegin, const char *pEnd, int64_t &v) {
+        while ((pBegin < pEnd) && isspace((unsigned char)*pBegin))
+            ++pBegin;
+        while ((pEnd > pBegin) && isspace((unsigned char)pEnd[-1]))
+            --pEnd;
+        const std::from_chars_result res = std::from_chars(pBegin, pEnd, v);
+        return (res.ec == std::errc()) && (res.ptr == pEnd) && (pBegin < pEnd);
+    }
+
+    // parses a number at the beginning of a line, as strtof would (NAN if not parseable or overrange)
+    static float parseFloatLine(const char *pBegin, const char *pEnd) {
+        // === fast path: std::from_chars (accepts no leading whitespace, '+' or hex) ===
+        const char *p = pBegin;
+        while ((p < pEnd) && ((*p == ' ') || (*p == '\t') || (*p == '\r') || (*p == '\v') || (*p == '\f')))
+            ++p;
+        const char *pDigits = ((p < pEnd) && (*p == '-')) ? p + 1 : p;
+        const bool isHex = (pEnd - pDigits >= 2) && (pDigits[0] == '0') && ((pDigits[1] == 'x') || (pDigits[1] == 'X'));
+        float val;
+        bool done = false;
+        if ((p < pEnd) && (*p != '+') && !isHex) {
+            std::from_chars_result res = std::from_chars(p, pEnd, val);
+            if (res.ec == std::errc::invalid_argument)
+                return std::numeric_limits<float>::quiet_NaN();
+            done = (res.ec == std::errc());  // (out of range: strtof decides between overrange and underflow)
+        }
+
+        // === slow path: strtof on a copy ===
+        if (!done) {
+            const string line(pBegin, pEnd);
             const char *str = line.c_str();
             char *endptr;
-            float val = std::strtof(str, &endptr);
-            if (/*conversion failed*/ (endptr == str) || /*overrange */ (val == HUGE_VALF))
-                val = std::numeric_limits<float>::quiet_NaN();
-            r.push_back(val);
+            val = std::strtof(str, &endptr);
+            if (/*conversion failed*/ endptr == str)
+                return std::numeric_limits<float>::quiet_NaN();
         }
-        return r;
+        if (/*overrange */ val == HUGE_VALF)
+            val = std::numeric_limits<float>::quiet_NaN();
+        return val;
+    }
+
+    // runs fn(ix) for ix = 0..n-1 in parallel, on at most one thread per core (as compressedFile_cl::runJobs)
+    template <typename fn_t>
+    static void runParallel(size_t n, fn_t fn) {
+        std::atomic<size_t> next{0};
+        auto worker = [&]() {
+            for (size_t ix; (ix = next++) < n;)
+                fn(ix);
+        };
+        const size_t nThreads = std::min((size_t)std::max(std::thread::hardware_concurrency(), 1u), n);
+        vector<std::future<void>> futs;
+        for (size_t ix = 1; ix < nThreads; ++ix)
+            futs.push_back(std::async(std::launch::async, worker));
+        worker();
+        for (std::future<void> &f : futs)
+            f.get();
     }
 };